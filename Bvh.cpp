@@ -0,0 +1,232 @@
+﻿// Bvh.cpp : レイキャスト用のBVH（境界ボリューム階層）の作成
+// 三角形の重心を軸ごとにビンに分けてSAHで分割位置を決める（ビン分割SAH）
+// 大きな部分木は別スレッドで作成する
+
+#include "Bvh.h"
+#include <algorithm>
+#include <cfloat>
+#include <future>
+#include <thread>
+
+using namespace DirectX;
+using namespace ObjToImdl;
+
+constexpr int BinCount = 16;            // 軸ごとのビンの数
+constexpr uint32_t MaxLeafSize = 8;     // SAHで分割しない場合の葉の最大プリミティブ数
+constexpr float TraversalCost = 1.0f;   // 三角形との交差判定に対する節の処理の相対コスト
+constexpr uint32_t ParallelSize = 4096; // この数以上のプリミティブを持つ部分木は別スレッドで作成
+
+// 軸平行境界ボックス
+struct Aabb
+{
+    XMVECTOR min = XMVectorReplicate(FLT_MAX);
+    XMVECTOR max = XMVectorReplicate(-FLT_MAX);
+
+    void Grow(FXMVECTOR p) { min = XMVectorMin(min, p); max = XMVectorMax(max, p); }
+    void Grow(const Aabb& b) { min = XMVectorMin(min, b.min); max = XMVectorMax(max, b.max); }
+
+    // 表面積（空の場合は0）
+    float Area() const
+    {
+        XMFLOAT3 d;
+        XMStoreFloat3(&d, max - min);
+        if (d.x < 0.0f) return 0.0f;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+};
+
+// 作成中のBVHの共有データ
+struct BuildContext
+{
+    std::vector<Aabb> bounds;           // 三角形ごとの境界ボックス
+    std::vector<XMFLOAT3> centroids;    // 三角形ごとの重心
+    uint32_t* primitives;               // 三角形の番号（部分木ごとに範囲を並べ替える）
+    int parallelDepth;                  // 別スレッドで作成する深さの上限
+};
+
+// 葉のノードを追加する関数
+static void AddLeaf(const Aabb& bounds, uint32_t begin, uint32_t count, std::vector<BvhNode>& nodes)
+{
+    BvhNode node = {};
+    XMStoreFloat3(&node.boundsMin, bounds.min);
+    XMStoreFloat3(&node.boundsMax, bounds.max);
+    node.offset = begin;
+    node.primCount = static_cast<uint16_t>(count);
+    nodes.push_back(node);
+}
+
+// primitives[begin, end) の部分木を作成してnodesの末尾に追加する関数（ノード番号はnodesの先頭からの位置）
+static void BuildNode(BuildContext& ctx, uint32_t begin, uint32_t end, int depth, std::vector<BvhNode>& nodes)
+{
+    const uint32_t count = end - begin;
+
+    // 範囲の境界ボックスと重心の範囲
+    Aabb bounds, centroidBounds;
+    for (uint32_t i = begin; i < end; i++)
+    {
+        uint32_t prim = ctx.primitives[i];
+        bounds.Grow(ctx.bounds[prim]);
+        centroidBounds.Grow(XMLoadFloat3(&ctx.centroids[prim]));
+    }
+
+    if (count == 1)
+    {
+        AddLeaf(bounds, begin, count, nodes);
+        return;
+    }
+
+    XMFLOAT3 cmin, cmax;
+    XMStoreFloat3(&cmin, centroidBounds.min);
+    XMStoreFloat3(&cmax, centroidBounds.max);
+    const float lo[3] = { cmin.x, cmin.y, cmin.z };
+    const float extent[3] = { cmax.x - cmin.x, cmax.y - cmin.y, cmax.z - cmin.z };
+
+    auto binIndex = [&](uint32_t prim, int axis) {
+        const XMFLOAT3& c = ctx.centroids[prim];
+        float v = (axis == 0) ? c.x : (axis == 1) ? c.y : c.z;
+        int bin = static_cast<int>((v - lo[axis]) * (BinCount / extent[axis]));
+        return std::min(std::max(bin, 0), BinCount - 1);
+    };
+
+    // ---- 各軸のビンの境界で分割した場合のコストを求める ----
+    int bestAxis = -1;
+    int bestSplit = 0;
+    float bestCost = FLT_MAX;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (extent[axis] <= 0.0f) continue;
+
+        Aabb binBounds[BinCount];
+        uint32_t binCounts[BinCount] = {};
+        for (uint32_t i = begin; i < end; i++)
+        {
+            uint32_t prim = ctx.primitives[i];
+            int bin = binIndex(prim, axis);
+            binBounds[bin].Grow(ctx.bounds[prim]);
+            binCounts[bin]++;
+        }
+
+        // 右側から累積した面積と数
+        float rightArea[BinCount];
+        uint32_t rightCount[BinCount];
+        Aabb acc;
+        uint32_t n = 0;
+        for (int bin = BinCount - 1; bin > 0; bin--)
+        {
+            acc.Grow(binBounds[bin]);
+            n += binCounts[bin];
+            rightArea[bin] = acc.Area();
+            rightCount[bin] = n;
+        }
+
+        // 左側を累積しながら各分割位置のコストを評価
+        acc = Aabb();
+        n = 0;
+        for (int split = 1; split < BinCount; split++)
+        {
+            acc.Grow(binBounds[split - 1]);
+            n += binCounts[split - 1];
+            if (n == 0 || rightCount[split] == 0) continue;
+
+            float cost = acc.Area() * n + rightArea[split] * rightCount[split];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = split;
+            }
+        }
+    }
+
+    // ---- 分割するかどうか ----
+    float area = bounds.Area();
+    bestCost = (area > 0.0f) ? TraversalCost + bestCost / area : FLT_MAX;
+
+    uint32_t mid;
+    if (bestAxis >= 0 && (bestCost < count || count > MaxLeafSize))
+    {
+        uint32_t* first = ctx.primitives + begin;
+        uint32_t* last = ctx.primitives + end;
+        mid = begin + static_cast<uint32_t>(std::partition(first, last, [&](uint32_t prim) {
+            return binIndex(prim, bestAxis) < bestSplit;
+        }) - first);
+    }
+    else if (count <= MaxLeafSize)
+    {
+        AddLeaf(bounds, begin, count, nodes);
+        return;
+    }
+    else
+    {
+        // 重心がすべて同じ位置にある場合は数で半分に分ける
+        bestAxis = 0;
+        mid = begin + count / 2;
+    }
+
+    // ---- 節を追加して子を作成 ----
+    size_t self = nodes.size();
+    BvhNode node = {};
+    XMStoreFloat3(&node.boundsMin, bounds.min);
+    XMStoreFloat3(&node.boundsMax, bounds.max);
+    node.axis = static_cast<uint16_t>(bestAxis);
+    nodes.push_back(node);
+
+    if (depth < ctx.parallelDepth && count >= ParallelSize)
+    {
+        // 右の部分木は別スレッドで作成して、ノード番号をずらして連結する
+        std::vector<BvhNode> right;
+        auto task = std::async(std::launch::async, [&]() {
+            BuildNode(ctx, mid, end, depth + 1, right);
+        });
+        BuildNode(ctx, begin, mid, depth + 1, nodes);
+        task.get();
+
+        uint32_t base = static_cast<uint32_t>(nodes.size());
+        for (auto& child : right)
+        {
+            if (child.primCount == 0) child.offset += base;
+        }
+        nodes[self].offset = base;
+        nodes.insert(nodes.end(), right.begin(), right.end());
+    }
+    else
+    {
+        BuildNode(ctx, begin, mid, depth + 1, nodes);
+        nodes[self].offset = static_cast<uint32_t>(nodes.size());
+        BuildNode(ctx, mid, end, depth + 1, nodes);
+    }
+}
+
+// 三角形リストからSAH（表面積ヒューリスティック）でBVHを作成する関数
+void ObjToImdl::BuildBvh(const std::vector<VertexPositionNormalTextureTangent>& vertices,
+                         const uint16_t* indices, size_t triangleCount,
+                         std::vector<BvhNode>& nodes,
+                         std::vector<uint32_t>& primitives)
+{
+    nodes.clear();
+    primitives.resize(triangleCount);
+    if (triangleCount == 0) return;
+
+    BuildContext ctx;
+    ctx.bounds.resize(triangleCount);
+    ctx.centroids.resize(triangleCount);
+    for (size_t i = 0; i < triangleCount; i++)
+    {
+        Aabb& b = ctx.bounds[i];
+        for (int k = 0; k < 3; k++)
+        {
+            b.Grow(XMLoadFloat3(&vertices[indices[i * 3 + k]].position));
+        }
+        XMStoreFloat3(&ctx.centroids[i], (b.min + b.max) * 0.5f);
+        primitives[i] = static_cast<uint32_t>(i);
+    }
+    ctx.primitives = primitives.data();
+
+    // スレッド数がコア数程度になる深さまで並列に作成する
+    unsigned int threads = std::max(std::thread::hardware_concurrency(), 1u);
+    ctx.parallelDepth = 0;
+    while ((1u << ctx.parallelDepth) < threads) ctx.parallelDepth++;
+
+    nodes.reserve(triangleCount * 2 / MaxLeafSize + 1);
+    BuildNode(ctx, 0, static_cast<uint32_t>(triangleCount), 0, nodes);
+}
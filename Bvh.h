@@ -0,0 +1,17 @@
+﻿// Bvh.h : レイキャスト用のBVH（境界ボリューム階層）の作成
+
+#pragma once
+
+#include "ObjToMdl.h"
+#include <cstdint>
+#include <vector>
+
+namespace ObjToImdl
+{
+    // 三角形リストからSAH（表面積ヒューリスティック）でBVHを作成する関数
+    // primitivesには葉から参照する三角形の番号（indices / 3）を格納する
+    void BuildBvh(const std::vector<VertexPositionNormalTextureTangent>& vertices,
+                  const uint16_t* indices, size_t triangleCount,
+                  std::vector<BvhNode>& nodes,
+                  std::vector<uint32_t>& primitives);
+}
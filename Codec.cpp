@@ -0,0 +1,378 @@
+﻿// Codec.cpp : インデックス情報と頂点情報の圧縮
+//
+// 圧縮したデータの形式（IDXC、VTXCセクション共通）
+//      要素の数(uint32_t)                インデックスの数、または頂点の数
+//      符号化したサイズ(uint32_t)        エントロピー符号化の前のサイズ
+//      エントロピー符号化したデータ      COMPRESS_ALGORITHM_XPRESS_HUFF
+//
+// インデックスの符号化（三角形ごと）
+//      最近の三角形の辺（逆向き）を EdgeFifoSize 個まで記録しておき、
+//      三角形の辺が記録にあれば残りの１頂点のみを出力する
+//      |コード(uint8_t)                  |
+//      |頂点(可変長整数 * 0～3)          |
+//      コードの下位4ビット：辺の記録の位置（EdgeFifoSizeの場合は辺なし）
+//      辺あり：ビット4-5 = 三角形の回転、ビット6 = 残りの頂点が新しい頂点
+//      辺なし：ビット4-6 = 各頂点が新しい頂点
+//      新しい頂点（これまでで最大の頂点+1）は省略し、それ以外は直前の頂点との差分を出力する
+//      三角形にならない末尾のインデックスは差分のみを出力する
+//
+// 頂点の符号化
+//      頂点のバイトごとに直前の頂点との差分を求め、同じ位置のバイトを連続して並べる
+//
+// 圧縮したセクション（'ZSEC'）の内容
+//      元のセクションID(uint32_t)
+//      圧縮形式(uint32_t)                SectionCodec_*
+//      元のサイズ(uint32_t)
+//      圧縮したデータ
+
+#include "Codec.h"
+#include <windows.h>
+#include <compressapi.h>
+#include <cstring>
+#include <stdexcept>
+
+using namespace ObjToImdl;
+
+constexpr uint32_t EdgeFifoSize = 15;                   // 記録する辺の数
+constexpr uint32_t EntropyAlgorithm = COMPRESS_ALGORITHM_XPRESS_HUFF;
+
+// 可変長整数（符号付きはジグザグ符号化）の書き込み関数
+static void WriteVarint(std::vector<uint8_t>& out, int32_t value)
+{
+    uint32_t v = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    while (v >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+// 可変長整数の読み込み関数（失敗時はfalse）
+static bool ReadVarint(const uint8_t*& p, const uint8_t* end, int32_t& value)
+{
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        if (p == end) return false;
+        uint8_t b = *p++;
+        v |= static_cast<uint32_t>(b & 0x7f) << shift;
+        if (!(b & 0x80))
+        {
+            value = static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+// 圧縮したデータのヘッダーとエントロピー符号化したデータを追加する関数
+static void AppendEncoded(uint32_t count, const std::vector<uint8_t>& encoded, std::vector<char>& out)
+{
+    uint32_t header[2] = { count, static_cast<uint32_t>(encoded.size()) };
+    out.insert(out.end(), reinterpret_cast<const char*>(header), reinterpret_cast<const char*>(header + 2));
+    if (!CompressData(EntropyAlgorithm, encoded.data(), encoded.size(), out))
+    {
+        throw std::runtime_error("Compression failed");
+    }
+}
+
+// 圧縮したデータのヘッダーを読み込んでエントロピー符号化を展開する関数
+static bool ReadEncoded(const char* data, size_t size, uint32_t& count, std::vector<uint8_t>& encoded)
+{
+    uint32_t header[2];
+    if (size < sizeof(header)) return false;
+    memcpy(header, data, sizeof(header));
+    count = header[0];
+    encoded.resize(header[1]);
+    if (encoded.empty()) return true;
+    return DecompressData(EntropyAlgorithm, data + sizeof(header), size - sizeof(header), encoded.data(), encoded.size());
+}
+
+// インデックスの符号化・展開で共有する状態
+struct IndexCodecState
+{
+    uint32_t edges[EdgeFifoSize][2] = {};   // 最近の三角形の辺（逆向き）
+    uint32_t edgeCount = 0;                 // 記録した辺の数（EdgeFifoSizeで循環）
+    uint32_t next = 0;                      // 新しい頂点の番号
+    uint32_t last = 0;                      // 直前の頂点
+
+    // 三角形の辺を逆向きに記録（隣の三角形では逆向きに現れるため）
+    void PushTriangle(uint32_t a, uint32_t b, uint32_t c)
+    {
+        const uint32_t tri[3][2] = { { b, a }, { c, b }, { a, c } };
+        for (const auto& e : tri)
+        {
+            uint32_t slot = edgeCount++ % EdgeFifoSize;
+            edges[slot][0] = e[0];
+            edges[slot][1] = e[1];
+        }
+    }
+
+    // 辺の記録の位置（ない場合はEdgeFifoSize）
+    uint32_t FindEdge(uint32_t a, uint32_t b) const
+    {
+        uint32_t count = (edgeCount < EdgeFifoSize) ? edgeCount : EdgeFifoSize;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (edges[i][0] == a && edges[i][1] == b) return i;
+        }
+        return EdgeFifoSize;
+    }
+};
+
+// インデックス情報を圧縮してoutの末尾に追加する関数
+void ObjToImdl::EncodeIndexBuffer(const uint16_t* indices, size_t count, std::vector<char>& out)
+{
+    std::vector<uint8_t> encoded;
+    encoded.reserve(count * 2);
+
+    IndexCodecState state;
+
+    // 頂点を書き込む（新しい頂点の場合は省略してtrue）
+    std::vector<uint8_t> values;
+    auto writeVertex = [&](uint32_t v) {
+        bool isNext = (v == state.next);
+        if (isNext) state.next++;
+        else WriteVarint(values, static_cast<int32_t>(v) - static_cast<int32_t>(state.last));
+        state.last = v;
+        return isNext;
+    };
+
+    size_t triangleCount = count / 3;
+    for (size_t i = 0; i < triangleCount; i++)
+    {
+        const uint32_t t[3] = { indices[i * 3], indices[i * 3 + 1], indices[i * 3 + 2] };
+        values.clear();
+
+        // 記録にある辺を探す
+        uint32_t slot = EdgeFifoSize;
+        uint32_t rotation = 0;
+        for (; rotation < 3; rotation++)
+        {
+            slot = state.FindEdge(t[rotation], t[(rotation + 1) % 3]);
+            if (slot < EdgeFifoSize) break;
+        }
+
+        uint8_t code;
+        if (slot < EdgeFifoSize)
+        {
+            code = static_cast<uint8_t>(slot | rotation << 4);
+            if (writeVertex(t[(rotation + 2) % 3])) code |= 1 << 6;
+        }
+        else
+        {
+            code = EdgeFifoSize;
+            for (int k = 0; k < 3; k++)
+            {
+                if (writeVertex(t[k])) code |= 1 << (4 + k);
+            }
+        }
+
+        encoded.push_back(code);
+        encoded.insert(encoded.end(), values.begin(), values.end());
+        state.PushTriangle(t[0], t[1], t[2]);
+    }
+
+    // 三角形にならない末尾
+    for (size_t i = triangleCount * 3; i < count; i++)
+    {
+        WriteVarint(encoded, static_cast<int32_t>(indices[i]) - static_cast<int32_t>(state.last));
+        state.last = indices[i];
+    }
+
+    AppendEncoded(static_cast<uint32_t>(count), encoded, out);
+}
+
+// 圧縮したインデックス情報の展開関数
+bool ObjToImdl::DecodeIndexBuffer(const char* data, size_t size, std::vector<uint16_t>& indices)
+{
+    uint32_t count = 0;
+    std::vector<uint8_t> encoded;
+    if (!ReadEncoded(data, size, count, encoded)) return false;
+
+    indices.resize(count);
+
+    const uint8_t* p = encoded.data();
+    const uint8_t* end = p + encoded.size();
+    IndexCodecState state;
+
+    // 頂点を読み込む（isNextの場合は新しい頂点）
+    auto readVertex = [&](bool isNext, uint32_t& v) {
+        if (isNext)
+        {
+            v = state.next++;
+        }
+        else
+        {
+            int32_t delta;
+            if (!ReadVarint(p, end, delta)) return false;
+            v = static_cast<uint32_t>(static_cast<int32_t>(state.last) + delta);
+        }
+        state.last = v;
+        return v <= UINT16_MAX;
+    };
+
+    size_t triangleCount = count / 3;
+    for (size_t i = 0; i < triangleCount; i++)
+    {
+        if (p == end) return false;
+        uint8_t code = *p++;
+        uint32_t slot = code & 0x0f;
+        uint32_t t[3];
+
+        if (slot < EdgeFifoSize)
+        {
+            uint32_t rotation = (code >> 4) & 3;
+            if (rotation > 2 || slot >= state.edgeCount) return false;
+            t[rotation] = state.edges[slot][0];
+            t[(rotation + 1) % 3] = state.edges[slot][1];
+            if (!readVertex((code & (1 << 6)) != 0, t[(rotation + 2) % 3])) return false;
+        }
+        else
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                if (!readVertex((code & (1 << (4 + k))) != 0, t[k])) return false;
+            }
+        }
+
+        indices[i * 3] = static_cast<uint16_t>(t[0]);
+        indices[i * 3 + 1] = static_cast<uint16_t>(t[1]);
+        indices[i * 3 + 2] = static_cast<uint16_t>(t[2]);
+        state.PushTriangle(t[0], t[1], t[2]);
+    }
+
+    // 三角形にならない末尾
+    for (size_t i = triangleCount * 3; i < count; i++)
+    {
+        uint32_t v;
+        if (!readVertex(false, v)) return false;
+        indices[i] = static_cast<uint16_t>(v);
+    }
+
+    return p == end;
+}
+
+// 頂点情報を圧縮してoutの末尾に追加する関数
+void ObjToImdl::EncodeVertexBuffer(const std::vector<VertexPositionNormalTextureTangent>& vertices, std::vector<char>& out)
+{
+    constexpr size_t stride = sizeof(VertexPositionNormalTextureTangent);
+    const size_t count = vertices.size();
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(vertices.data());
+
+    // バイトごとの差分を同じ位置のバイトごとに並べる
+    std::vector<uint8_t> encoded(count * stride);
+    for (size_t j = 0; j < stride; j++)
+    {
+        uint8_t* plane = &encoded[j * count];
+        uint8_t prev = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            uint8_t b = src[i * stride + j];
+            plane[i] = static_cast<uint8_t>(b - prev);
+            prev = b;
+        }
+    }
+
+    AppendEncoded(static_cast<uint32_t>(count), encoded, out);
+}
+
+// 圧縮した頂点情報の展開関数
+bool ObjToImdl::DecodeVertexBuffer(const char* data, size_t size, std::vector<VertexPositionNormalTextureTangent>& vertices)
+{
+    constexpr size_t stride = sizeof(VertexPositionNormalTextureTangent);
+
+    uint32_t count = 0;
+    std::vector<uint8_t> encoded;
+    if (!ReadEncoded(data, size, count, encoded)) return false;
+    if (encoded.size() != static_cast<size_t>(count) * stride) return false;
+
+    vertices.resize(count);
+    uint8_t* dst = reinterpret_cast<uint8_t*>(vertices.data());
+
+    uint8_t prev[stride] = {};
+    for (size_t i = 0; i < count; i++)
+    {
+        for (size_t j = 0; j < stride; j++)
+        {
+            prev[j] = static_cast<uint8_t>(prev[j] + encoded[j * count + i]);
+            dst[i * stride + j] = prev[j];
+        }
+    }
+
+    return true;
+}
+
+// Windowsの圧縮APIでデータを圧縮する関数
+bool ObjToImdl::CompressData(uint32_t algorithm, const void* data, size_t size, std::vector<char>& out)
+{
+    COMPRESSOR_HANDLE compressor = nullptr;
+    if (!CreateCompressor(algorithm, nullptr, &compressor)) return false;
+
+    // 圧縮後のサイズを取得してから圧縮する
+    size_t compressedSize = 0;
+    bool ok = Compress(compressor, data, size, nullptr, 0, &compressedSize) || GetLastError() == ERROR_INSUFFICIENT_BUFFER;
+    if (ok)
+    {
+        size_t offset = out.size();
+        out.resize(offset + compressedSize);
+        ok = Compress(compressor, data, size, out.data() + offset, compressedSize, &compressedSize) != FALSE;
+        out.resize(ok ? offset + compressedSize : offset);
+    }
+
+    CloseCompressor(compressor);
+    return ok;
+}
+
+// Windowsの圧縮APIで圧縮したデータの展開関数
+bool ObjToImdl::DecompressData(uint32_t algorithm, const void* data, size_t size, void* out, size_t rawSize)
+{
+    DECOMPRESSOR_HANDLE decompressor = nullptr;
+    if (!CreateDecompressor(algorithm, nullptr, &decompressor)) return false;
+
+    size_t decompressedSize = 0;
+    bool ok = Decompress(decompressor, data, size, out, rawSize, &decompressedSize) && decompressedSize == rawSize;
+
+    CloseDecompressor(decompressor);
+    return ok;
+}
+
+// 圧縮形式に対応するWindowsの圧縮APIのアルゴリズムを取得する関数（未対応の場合は0）
+static uint32_t GetAlgorithm(uint32_t codec)
+{
+    switch (codec)
+    {
+    case SectionCodec_Xpress:       return COMPRESS_ALGORITHM_XPRESS;
+    case SectionCodec_XpressHuff:   return COMPRESS_ALGORITHM_XPRESS_HUFF;
+    case SectionCodec_Lzms:         return COMPRESS_ALGORITHM_LZMS;
+    default:                        return 0;
+    }
+}
+
+// セクションを圧縮する関数
+bool ObjToImdl::WrapSection(uint32_t id, uint32_t codec, const char* data, size_t size, std::vector<char>& out)
+{
+    uint32_t algorithm = GetAlgorithm(codec);
+    if (algorithm == 0) return false;
+
+    uint32_t header[3] = { id, codec, static_cast<uint32_t>(size) };
+    out.assign(reinterpret_cast<const char*>(header), reinterpret_cast<const char*>(header + 3));
+    return CompressData(algorithm, data, size, out);
+}
+
+// 圧縮したセクションを展開する関数
+bool ObjToImdl::UnwrapSection(const char* data, size_t size, uint32_t& id, std::vector<char>& out)
+{
+    uint32_t header[3];
+    if (size < sizeof(header)) return false;
+    memcpy(header, data, sizeof(header));
+
+    uint32_t algorithm = GetAlgorithm(header[1]);
+    if (algorithm == 0) return false;
+
+    id = header[0];
+    out.resize(header[2]);
+    if (out.empty()) return true;
+    return DecompressData(algorithm, data + sizeof(header), size - sizeof(header), out.data(), out.size());
+}
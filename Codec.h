@@ -0,0 +1,36 @@
+﻿// Codec.h : インデックス情報と頂点情報の圧縮
+// インデックスは辺を共有する三角形を参照して、頂点はバイトごとの差分にしてから
+// Windowsの圧縮API（XPRESS + ハフマン符号）でエントロピー符号化する
+
+#pragma once
+
+#include "ObjToMdl.h"
+#include <cstdint>
+#include <vector>
+
+namespace ObjToImdl
+{
+    // インデックス情報を圧縮してoutの末尾に追加する関数
+    void EncodeIndexBuffer(const uint16_t* indices, size_t count, std::vector<char>& out);
+
+    // 圧縮したインデックス情報の展開関数（失敗時はfalse）
+    bool DecodeIndexBuffer(const char* data, size_t size, std::vector<uint16_t>& indices);
+
+    // 頂点情報を圧縮してoutの末尾に追加する関数
+    void EncodeVertexBuffer(const std::vector<VertexPositionNormalTextureTangent>& vertices, std::vector<char>& out);
+
+    // 圧縮した頂点情報の展開関数（失敗時はfalse）
+    bool DecodeVertexBuffer(const char* data, size_t size, std::vector<VertexPositionNormalTextureTangent>& vertices);
+
+    // Windowsの圧縮APIでデータを圧縮する関数（algorithmはCOMPRESS_ALGORITHM_*、失敗時はfalse）
+    bool CompressData(uint32_t algorithm, const void* data, size_t size, std::vector<char>& out);
+
+    // Windowsの圧縮APIで圧縮したデータの展開関数（rawSizeは展開後のサイズ、失敗時はfalse）
+    bool DecompressData(uint32_t algorithm, const void* data, size_t size, void* out, size_t rawSize);
+
+    // セクションを圧縮形式codec（SectionCodec_*）で圧縮して、圧縮したセクションの内容をoutに格納する関数（失敗時はfalse）
+    bool WrapSection(uint32_t id, uint32_t codec, const char* data, size_t size, std::vector<char>& out);
+
+    // 圧縮したセクションの内容から元のセクションIDと内容を取得する関数（失敗時はfalse）
+    bool UnwrapSection(const char* data, size_t size, uint32_t& id, std::vector<char>& out);
+}
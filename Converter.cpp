@@ -0,0 +1,3166 @@
+﻿// Converter.cpp : wavefront形式のファイルを独自形式のモデルデータに変換する処理
+
+// ------------------------------------------------------------ //
+// モデルデータフォーマット
+//
+// テクスチャ名の数(uint32_t)
+//      |テクスチャ名の文字数(uint32_t)   |*cnt
+//      |テクスチャ名(char)               |
+//
+// マテリアル名の数(uint32_t)
+//      |マテリアル名の文字数(uint32_t)   |*cnt
+//      |マテリアル名(char)               |
+//
+// マテリアルの数(uint32_t)
+//      マテリアル(MaterialInfo*cnt)
+//
+// メッシュ情報の数(uint32_t)
+//      メッシュ情報(MeshInfo*cnt)
+//
+// インデックス情報の数(uint32_t)
+//      インデックス情報(uint16_t * cnt)
+//
+// 頂点情報の数(uint32_t)
+//      頂点情報(VertexPositionNormalTextureTangent * cnt)
+//
+// 拡張セクション（省略可能、ファイルの終端まで繰り返す。未対応のIDは読み飛ばす）
+//      |セクションID(uint32_t)           |*cnt
+//      |セクションのサイズ(uint32_t)     |
+//      |セクションのデータ(char * size)  |
+//
+// 圧縮したインデックス情報セクション（'IDXC'）、圧縮した頂点情報セクション（'VTXC'）
+//      形式はCodec.cppを参照
+//      圧縮して出力する場合はインデックス情報と頂点情報の数を0にしてこのセクションを先頭に置く
+//
+// インデックス情報セクション（'IBUF'）、頂点情報セクション（'VBUF'）
+//      インデックス情報(uint16_t * cnt)、頂点情報(VertexPositionNormalTextureTangent * cnt)
+//      セクションを圧縮して出力する場合はインデックス情報と頂点情報の数を0にしてこのセクションを先頭に置く
+//
+// 圧縮したセクション（'ZSEC'）
+//      任意のセクションを圧縮したもの（形式はCodec.cppを参照）
+//      圧縮後のサイズが元のサイズ * 指定の比率以下になるセクションのみ圧縮する
+//
+// チャンクテーブルセクション（'CHNK'）
+//      チャンクの数(uint32_t)
+//      チャンク情報(ChunkInfo * cnt)     メッシュ情報ごとにLOD0、LOD1...の順に並ぶ
+//
+// チャンクデータセクション（'CDAT'）最後のセクション、圧縮しない
+//      |頂点情報(VertexPositionNormalTextureTangent * vertexCount)   |*cnt
+//      |インデックス情報(uint16_t * indexCount)  4バイト境界まで0で埋める|
+//      チャンク形式ではインデックス情報と頂点情報の数は0、メッシュ情報とLOD情報のstartIndexは0
+//      （チャンクごとに非同期に読み込めるように、必要なデータはすべてチャンク内にある）
+//
+// プリミティブの形式セクション（'TOPO'）
+//      プリミティブの形式(MeshTopology * メッシュ情報の数)
+//      ストリップの場合はメッシュ情報のstartIndexからindexCount個のインデックスを使用する
+//      （primCountは三角形の数のまま）
+//
+// 拡張マテリアルセクション（'MTLX'）拡張パラメータを使用するマテリアルがある場合のみ出力する
+//      拡張マテリアル(MaterialInfoEx * マテリアルの数)
+//
+// オブジェクトの範囲セクション（'OBJR'）
+//      オブジェクトの範囲の数(uint32_t)
+//      オブジェクトの範囲(ObjectRange * cnt)   メッシュ情報の順に並ぶ
+//
+// ノードセクション（'NODE'）
+//      ノードの数(uint32_t)
+//      ノード情報(NodeInfo * cnt)        objファイルのo、gの順に並ぶ
+//      |ノード名の文字数(uint32_t)       |*cnt
+//      |ノード名(char)                   |
+//      形状を共有するノードはメッシュ情報を出力せず、共有されるノードのメッシュ情報を参照する
+//
+// パックファイルの参照セクション（'PREF'）
+//      形式はPack.cppを参照
+//      パックファイルに出力する場合はインデックス情報と頂点情報の数を0にしてこのセクションを先頭に置く
+//
+// LODセクション（'LOD '）
+//      LODのレベル数(uint32_t)           LOD0（メッシュ情報）を含まない
+//      LOD情報(LodInfo * メッシュ情報の数 * レベル数)
+//                                        メッシュ情報ごとにレベル順に並ぶ
+//                                        インデックスはインデックス情報の末尾に追加
+//
+// 境界ボリュームセクション（'BNDS'）
+//      モデル全体の境界ボリューム(BoundingVolume)
+//      メッシュ情報ごとの境界ボリューム(BoundingVolume * メッシュ情報の数)
+//
+// メッシュレットセクション（'MSHL'）
+//      メッシュレットの数(uint32_t)
+//      メッシュレット(Meshlet * cnt)
+//      メッシュレットの範囲(MeshletRange * メッシュ情報の数)
+//      頂点インデックスの数(uint32_t)
+//      頂点インデックス(uint16_t * cnt)  4バイト境界まで0で埋める
+//      三角形の数(uint32_t)
+//      ローカルインデックス(uint8_t * 3 * cnt)
+//
+// BVHセクション（'BVH '）
+//      ノードの数(uint32_t)
+//      ノード(BvhNode * cnt)             先頭が根
+//      プリミティブの数(uint32_t)
+//      プリミティブ(uint32_t * cnt)      三角形の番号（インデックス情報の位置 / 3）
+//                                        メッシュ情報の範囲の三角形（LODを含まない）が対象
+//
+// ------------------------------------------------------------ //
+
+#include "Converter.h"
+#include "Bvh.h"
+#include "Codec.h"
+#include "ImageHeader.h"
+#include "Meshlet.h"
+#include "Pack.h"
+#include "Simplify.h"
+#include "Strip.h"
+#include "Triangulate.h"
+#include <windows.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+#include <memory_resource>
+#include <cstring>
+#include <cfloat>
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+
+using namespace DirectX;
+using namespace ObjToImdl;
+
+// 面の各頂点を構成するインデックス
+struct FaceIndex
+{
+    int v;  // 位置
+    int vt; // テクスチャ座標
+    int vn; // 法線
+
+    bool operator==(const FaceIndex& other) const
+    {
+        return v == other.v && vt == other.vt && vn == other.vn;
+    }
+};
+
+// ハッシュ値を生成する関数
+namespace std
+{
+    template <>
+    struct hash<FaceIndex>
+    {
+        size_t operator()(const FaceIndex& f) const
+        {
+            size_t h1 = std::hash<int>()(f.v);
+            size_t h2 = std::hash<int>()(f.vt);
+            size_t h3 = std::hash<int>()(f.vn);
+
+            // ハッシュ合成
+            return h1 ^ (h2 << 1) ^ (h3 << 2);
+        }
+    };
+}
+
+// 面（三角形）
+struct Face
+{
+    FaceIndex faceIndices[3];
+    uint32_t smoothingGroup;    // スムージンググループ（0の場合はなし）
+};
+
+// 解析中のデータはすべてアリーナから確保し、変換終了時にまとめて解放する
+// （pmrのコンテナに格納される構造体はアロケータを受け取るコンストラクタを持つ）
+using ArenaAllocator = std::pmr::polymorphic_allocator<std::byte>;
+
+// サブメッシュ
+struct SubMesh
+{
+    using allocator_type = ArenaAllocator;
+
+    std::pmr::string material;      // マテリアル名
+    std::pmr::vector<Face> faces;   // 面（三角形）情報
+
+    explicit SubMesh(const allocator_type& alloc = {})
+        : material(alloc), faces(alloc) {}
+    SubMesh(const SubMesh& other, const allocator_type& alloc)
+        : material(other.material, alloc), faces(other.faces, alloc) {}
+    SubMesh(SubMesh&& other, const allocator_type& alloc)
+        : material(std::move(other.material), alloc), faces(std::move(other.faces), alloc) {}
+};
+
+// メッシュ（objファイルのoごと、ノードを出力する場合はgごとにも分ける）
+struct Mesh
+{
+    using allocator_type = ArenaAllocator;
+
+    std::pmr::string name;              // オブジェクト名またはグループ名
+    int32_t parent = -1;                // 親のメッシュの番号（gの場合は直前のo、ない場合は-1）
+    std::pmr::vector<SubMesh> subMeshs; // サブメッシュ
+
+    explicit Mesh(const allocator_type& alloc = {})
+        : name(alloc), subMeshs(alloc) {}
+    Mesh(const Mesh& other, const allocator_type& alloc)
+        : name(other.name, alloc), parent(other.parent), subMeshs(other.subMeshs, alloc) {}
+    Mesh(Mesh&& other, const allocator_type& alloc)
+        : name(std::move(other.name), alloc), parent(other.parent), subMeshs(std::move(other.subMeshs), alloc) {}
+};
+
+// obj形式の情報取得用構造体
+struct Object
+{
+    std::vector<std::string> mtllibs;               // マテリアルファイル名（現れた順）
+    std::pmr::vector<DirectX::XMFLOAT3> positions;  // 位置
+    std::pmr::vector<DirectX::XMFLOAT3> normals;    // 法線
+    std::pmr::vector<DirectX::XMFLOAT2> texcoords;  // テクスチャ座標
+    std::pmr::vector<Mesh> meshes;                  // メッシュ
+
+    explicit Object(std::pmr::memory_resource* resource)
+        : positions(resource), normals(resource), texcoords(resource), meshes(resource) {}
+};
+
+// objファイルの各行の数（バッファの予約用）
+struct ObjCounts
+{
+    size_t positions = 0;                   // v
+    size_t normals = 0;                     // vn
+    size_t texcoords = 0;                   // vt
+    size_t faces = 0;                       // f（三角形に分割後の数）
+    std::vector<uint32_t> meshSubMeshs;     // o、gごとのusemtlの数
+    std::vector<uint32_t> subMeshFaces;     // usemtlごとの三角形の数
+};
+
+// メモリの確保回数を数えるメモリリソース
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    explicit CountingResource(std::pmr::memory_resource* upstream)
+        : m_upstream(upstream), m_count(0), m_bytes(0) {}
+
+    size_t GetCount() const { return m_count; }
+    size_t GetBytes() const { return m_bytes; }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        m_count++;
+        m_bytes += bytes;
+        return m_upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        m_upstream->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::pmr::memory_resource* m_upstream;  // 実際に確保するメモリリソース
+    size_t m_count;                         // 確保回数
+    size_t m_bytes;                         // 確保サイズの合計
+};
+
+// 拡張セクション
+struct Section
+{
+    uint32_t id;                // セクションID
+    std::vector<char> data;     // データ
+};
+
+// バッファの末尾にデータを追加する関数
+static void AppendData(std::vector<char>& buffer, const void* data, size_t size)
+{
+    const char* p = static_cast<const char*>(data);
+    buffer.insert(buffer.end(), p, p + size);
+}
+
+// パス名付きファイル名のファイル名を取得する関数
+static std::string GetFileNameOnly(const std::string& path)
+{
+    return std::filesystem::path(path).filename().string();
+}
+
+// ファイルから読み込む関数（XMFLOAT2）
+static XMFLOAT2 ReadFloat2(std::istringstream& iss)
+{
+    XMFLOAT2 val = {};
+    iss >> val.x >> val.y;
+    return val;
+}
+
+// ファイルから読み込む関数（XMFLOAT3）
+static XMFLOAT3 ReadFloat3(std::istringstream& iss)
+{
+    XMFLOAT3 val = {};
+    iss >> val.x >> val.y >> val.z;
+    return val;
+}
+
+// テキストから１行取得する関数（改行コードは除去）
+static bool GetLine(std::string_view text, size_t& pos, std::string& line)
+{
+    if (pos >= text.size()) return false;
+
+    size_t end = text.find('\n', pos);
+    if (end == std::string_view::npos) end = text.size();
+
+    line.assign(text.data() + pos, end - pos);
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+
+    pos = end + 1;
+    return true;
+}
+
+// ファイルの内容を読み込む関数
+static int ReadFileText(const std::string& fname, std::string& text)
+{
+    std::ifstream ifs(fname, std::ios::binary);
+
+    if (!ifs)
+    {
+        // ファイルのオープン失敗
+        std::cout << "Could not open " << fname << std::endl;
+        return 1;
+    }
+
+    text.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    return 0;
+}
+
+// objファイルの行の種類と面の数を数える関数（１回目の走査）
+// groupsがtrueの場合はgでもメッシュを分ける（AnalyzeObjと同じ値にする）
+static ObjCounts PreScanObj(std::string_view text, bool groups)
+{
+    ObjCounts counts;
+    bool hasMaterial = false;   // gの後にマテリアルを引き継ぐか
+    bool inherit = false;       // 次の面でマテリアルを引き継いだサブメッシュを作るか
+
+    auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+
+    const char* p = text.data();
+    const char* end = p + text.size();
+
+    while (p < end)
+    {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (eol == nullptr) eol = end;
+
+        // 先頭のトークン
+        const char* t = p;
+        while (t < eol && isSpace(*t)) t++;
+        const char* te = t;
+        while (te < eol && !isSpace(*te)) te++;
+        std::string_view type(t, te - t);
+
+        if (type == "v") counts.positions++;
+        else if (type == "vn") counts.normals++;
+        else if (type == "vt") counts.texcoords++;
+        else if (type == "f")
+        {
+            // 角の数を数えて三角形の数に変換
+            size_t corners = 0;
+            for (const char* c = te; c < eol; )
+            {
+                while (c < eol && isSpace(*c)) c++;
+                if (c == eol) break;
+                corners++;
+                while (c < eol && !isSpace(*c)) c++;
+            }
+            if (corners >= 3)
+            {
+                if (inherit)
+                {
+                    counts.subMeshFaces.push_back(0);
+                    counts.meshSubMeshs.back()++;
+                    inherit = false;
+                }
+                counts.faces += corners - 2;
+                if (!counts.subMeshFaces.empty()) counts.subMeshFaces.back() += static_cast<uint32_t>(corners - 2);
+            }
+        }
+        else if (type == "o")
+        {
+            counts.meshSubMeshs.push_back(0);
+            hasMaterial = false;
+            inherit = false;
+        }
+        else if (type == "g" && groups)
+        {
+            counts.meshSubMeshs.push_back(0);
+            inherit = hasMaterial;
+        }
+        else if (type == "usemtl")
+        {
+            if (counts.meshSubMeshs.empty()) counts.meshSubMeshs.push_back(0);
+            counts.subMeshFaces.push_back(0);
+            counts.meshSubMeshs.back()++;
+            hasMaterial = true;
+            inherit = false;
+        }
+
+        p = eol + 1;
+    }
+
+    return counts;
+}
+
+// 面の各頂点を構成するインデックス取得関数
+static void ParseFaceLine(const std::string& line, Object& object, std::vector<FaceIndex>& result)
+{
+    auto fixIndex = [&](int raw, int size) {
+        if (raw > 0)  return raw - 1;
+        if (raw < 0)  return size + raw;
+        throw std::runtime_error("OBJ index cannot be zero");
+    };
+
+    std::istringstream iss(line);
+
+    std::string type;
+    iss >> type; // "f"
+
+    result.clear();
+
+    std::string token;
+    while (iss >> token)
+    {
+        FaceIndex idx{ -1, -1, -1 };
+
+        std::istringstream tss(token);
+        std::string s;
+
+        // v
+        if (std::getline(tss, s, '/')) idx.v = fixIndex(std::stoi(s), static_cast<int>(object.positions.size()));
+
+        // vt
+        if (std::getline(tss, s, '/'))
+        {
+            if (!s.empty()) idx.vt = fixIndex(std::stoi(s), static_cast<int>(object.texcoords.size()));
+        }
+
+        // vn
+        if (std::getline(tss, s, '/'))
+        {
+            if (!s.empty()) idx.vn = fixIndex(std::stoi(s), static_cast<int>(object.normals.size()));
+        }
+
+        result.push_back(idx);
+    }
+}
+
+// objファイルの情報取得関数
+// groupsがtrueの場合はgでもメッシュを分ける（falseの場合はgを無視する）
+static int AnalyzeObj(std::string_view text, const ObjCounts& counts, bool groups, Object& object)
+{
+    std::pmr::vector<Face>* pFace = nullptr;
+    std::string object_name;
+    int32_t objectIndex = -1;   // 直前のoのメッシュの番号
+    std::string inheritMaterial;        // gの後の最初の面で作るサブメッシュのマテリアル名
+    bool inherit = false;               // 次の面でマテリアルを引き継いだサブメッシュを作るか
+    std::vector<FaceIndex> result;
+    std::vector<XMFLOAT3> polygon;      // 多角形の頂点の位置
+    std::vector<uint32_t> triangles;    // 多角形を分割した三角形
+    uint32_t smoothingGroup = 0;        // 現在のスムージンググループ
+
+    // 事前に数えた数で各バッファを予約する
+    object.positions.reserve(counts.positions);
+    object.normals.reserve(counts.normals);
+    object.texcoords.reserve(counts.texcoords);
+    object.meshes.reserve(counts.meshSubMeshs.size());
+    size_t meshCount = 0;
+    size_t subMeshCount = 0;
+
+    size_t pos = 0;
+    std::string line;
+    while (GetLine(text, pos, line))
+    {
+        // 空行やコメントをスキップ
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream iss(line);
+
+        // 先頭のトークン
+        std::string type;
+        iss >> type;
+
+        // オブジェクト名
+        if (type == "o")
+        {
+            std::getline(iss >> std::ws, object_name);
+            objectIndex = static_cast<int32_t>(object.meshes.size());
+            Mesh& mesh = object.meshes.emplace_back();
+            mesh.name = object_name;
+            if (meshCount < counts.meshSubMeshs.size()) mesh.subMeshs.reserve(counts.meshSubMeshs[meshCount++]);
+            pFace = nullptr;
+            inherit = false;
+        }
+
+        // グループ名（直前のoの子としてメッシュを分け、マテリアルは引き継ぐ）
+        // 引き継いだマテリアルのサブメッシュは面がない場合に空の描画範囲にならないように最初の面で作る
+        if (type == "g" && groups)
+        {
+            std::getline(iss >> std::ws, object_name);
+            if (pFace != nullptr)
+            {
+                inheritMaterial = object.meshes.back().subMeshs.back().material;
+                inherit = true;
+            }
+
+            Mesh& mesh = object.meshes.emplace_back();
+            mesh.name = object_name;
+            mesh.parent = objectIndex;
+            if (meshCount < counts.meshSubMeshs.size()) mesh.subMeshs.reserve(counts.meshSubMeshs[meshCount++]);
+            pFace = nullptr;
+        }
+
+        // 頂点
+        if (type == "v")
+        {
+            object.positions.push_back(ReadFloat3(iss));
+        }
+
+        // 法線
+        else if (type == "vn")
+        {
+            object.normals.push_back(ReadFloat3(iss));
+        }
+
+        // テクスチャ座標
+        else if (type == "vt")
+        {
+            // BlenderのV座標は上が＋
+            XMFLOAT2 uv = ReadFloat2(iss);
+            uv.y = 1.0f - uv.y;
+            object.texcoords.push_back(uv);
+        }
+
+        // 面情報
+        else if (type == "f")
+        {
+            // gの前のマテリアルを引き継ぐ
+            if (pFace == nullptr && inherit)
+            {
+                object.meshes.back().subMeshs.emplace_back().material = inheritMaterial;
+                pFace = &object.meshes.back().subMeshs.back().faces;
+                if (subMeshCount < counts.subMeshFaces.size()) pFace->reserve(counts.subMeshFaces[subMeshCount++]);
+                inherit = false;
+            }
+
+            // マテリアルがない
+            if (pFace == nullptr)
+            {
+                std::cout << object_name << " has no material assigned." << std::endl;
+                return 1;
+            }
+
+            // 面の各頂点を構成するインデックスを取得
+            ParseFaceLine(line, object, result);
+            if (result.size() < 3) continue;
+
+            for (const auto& idx : result)
+            {
+                if (idx.v < 0 || idx.v >= static_cast<int>(object.positions.size())) throw std::runtime_error("OBJ index out of range");
+            }
+
+            // 三角形はそのまま使う
+            if (result.size() == 3)
+            {
+                // 時計回りが表
+                Face face{ { result[0], result[2], result[1] }, smoothingGroup };
+                pFace->push_back(face);
+                continue;
+            }
+
+            // 多角形は三角形に分割する（凹多角形は耳切り法）
+            polygon.clear();
+            for (const auto& idx : result) polygon.push_back(object.positions[idx.v]);
+            TriangulatePolygon(polygon.data(), polygon.size(), triangles);
+            for (size_t i = 0; i + 2 < triangles.size(); i += 3)
+            {
+                // 時計回りが表
+                Face face{ { result[triangles[i]], result[triangles[i + 2]], result[triangles[i + 1]] }, smoothingGroup };
+                pFace->push_back(face);
+            }
+        }
+
+        // マテリアル名
+        else if (type == "usemtl")
+        {
+            // oより前にある場合は名前のないメッシュを追加
+            if (object.meshes.empty())
+            {
+                object.meshes.emplace_back();
+                if (meshCount < counts.meshSubMeshs.size()) object.meshes.back().subMeshs.reserve(counts.meshSubMeshs[meshCount++]);
+            }
+
+            // メッシュを追加
+            object.meshes.back().subMeshs.emplace_back();
+
+            // マテリアル名
+            std::string material;
+            iss >> material;
+            object.meshes.back().subMeshs.back().material = material;
+
+            // 面を設定するポインタを更新
+            pFace = &object.meshes.back().subMeshs.back().faces;
+            if (subMeshCount < counts.subMeshFaces.size()) pFace->reserve(counts.subMeshFaces[subMeshCount++]);
+            inherit = false;
+        }
+
+        // スムージンググループ（offと0はなし）
+        else if (type == "s")
+        {
+            std::string group;
+            iss >> group;
+            smoothingGroup = (group == "off") ? 0 : static_cast<uint32_t>(std::strtoul(group.c_str(), nullptr, 10));
+        }
+
+        // マテリアルファイル名
+        else if (type == "mtllib")
+        {
+            std::string mtllib;
+            while (iss >> mtllib)
+            {
+                if (std::find(object.mtllibs.begin(), object.mtllibs.end(), mtllib) == object.mtllibs.end()) object.mtllibs.push_back(mtllib);
+            }
+        }
+    }
+
+    // gでも分けた場合は面のないサブメッシュを取り除く（usemtlの直後のgなどで空の描画範囲ができるため）
+    if (groups)
+    {
+        for (auto& mesh : object.meshes)
+        {
+            mesh.subMeshs.erase(std::remove_if(mesh.subMeshs.begin(), mesh.subMeshs.end(),
+                                               [](const SubMesh& subMesh) { return subMesh.faces.empty(); }),
+                                mesh.subMeshs.end());
+        }
+    }
+
+    return 0;
+}
+
+// ------------------------------------------------------------ //
+// 解析結果のキャッシュ（objファイルの解析結果をそのまま保存したもの）
+//
+// ヘッダー(ObjCacheHeader)
+// mtllibの数(uint32_t)
+//      |mtllibの文字数(uint32_t)                 |*cnt
+//      |mtllib(char)                             |
+// 位置(XMFLOAT3 * positionCount)
+// 法線(XMFLOAT3 * normalCount)
+// テクスチャ座標(XMFLOAT2 * texcoordCount)
+// メッシュの数(uint32_t)
+//      |メッシュ名の文字数(uint32_t)             |*cnt
+//      |メッシュ名(char)                         |
+//      |親のメッシュの番号(int32_t)              |
+//      |サブメッシュの数(uint32_t)               |
+//      |   |マテリアル名の文字数(uint32_t)       |*cnt
+//      |   |マテリアル名(char)                   |
+//      |   |面の数(uint32_t)                     |
+//      |   |面(Face * cnt)                       |
+//
+// objファイルのサイズと更新日時が一致する場合のみ使用する
+// ------------------------------------------------------------ //
+
+constexpr uint32_t ObjCacheMagic = MakeSectionId('O', 'B', 'J', 'C');
+constexpr uint32_t ObjCacheVersion = 5;     // 形式を変更したら更新する
+
+// キャッシュのヘッダー
+struct ObjCacheHeader
+{
+    uint32_t magic;             // ObjCacheMagic
+    uint32_t version;           // ObjCacheVersion
+    uint64_t sourceSize;        // objファイルのサイズ
+    int64_t sourceTime;         // objファイルの更新日時
+    uint32_t positionCount;     // 位置の数
+    uint32_t normalCount;       // 法線の数
+    uint32_t texcoordCount;     // テクスチャ座標の数
+    uint32_t faceCount;         // 面の数（全サブメッシュの合計）
+    uint32_t groups;            // gでもメッシュを分けたか（0または1）
+};
+
+// 読み込み専用でメモリにマップしたファイル
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        Close();
+    }
+
+    // マップを解除してファイルを閉じる
+    void Close()
+    {
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+        m_data = nullptr;
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+        m_size = 0;
+    }
+
+    // ファイルをマップする（失敗時はfalse）
+    bool Open(const std::string& path)
+    {
+        m_file = CreateFileW(std::filesystem::path(path).wstring().c_str(), GENERIC_READ, FILE_SHARE_READ,
+                             nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) return false;
+
+        m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_mapping) return false;
+
+        m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        m_size = static_cast<size_t>(size.QuadPart);
+        return m_data != nullptr;
+    }
+
+    const char* GetData() const { return m_data; }
+    size_t GetSize() const { return m_size; }
+
+private:
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+// データのハッシュ値（FNV-1a）を求める関数（hashに続けて計算する）
+static uint64_t HashData(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= static_cast<const unsigned char*>(data)[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// キャッシュファイル名を取得する関数（同じ名前の別のファイルと区別するためにフルパスのハッシュ値を付ける）
+static std::string GetCachePath(const std::string& directory, const std::string& source)
+{
+    std::error_code ec;
+    std::string full = std::filesystem::absolute(source, ec).string();
+
+    uint64_t hash = HashData(full.data(), full.size());
+
+    std::ostringstream name;
+    name << std::filesystem::path(source).stem().string() << "_" << std::hex << hash << ".objcache";
+
+    std::filesystem::path p(directory);
+    p /= name.str();
+    return p.string();
+}
+
+// objファイルのサイズと更新日時を取得する関数（失敗時はfalse）
+static bool GetSourceInfo(const std::string& path, uint64_t& size, int64_t& time)
+{
+    std::error_code ec;
+    size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    time = static_cast<int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+    return !ec;
+}
+
+// 解析結果をキャッシュに保存する関数（失敗しても変換は続ける）
+static void SaveObjCache(const std::string& path, const Object& object, const ObjCacheHeader& source)
+{
+    std::vector<char> data;
+
+    ObjCacheHeader header = source;
+    header.positionCount = static_cast<uint32_t>(object.positions.size());
+    header.normalCount = static_cast<uint32_t>(object.normals.size());
+    header.texcoordCount = static_cast<uint32_t>(object.texcoords.size());
+    header.faceCount = 0;
+    for (const auto& mesh : object.meshes)
+    {
+        for (const auto& subMesh : mesh.subMeshs) header.faceCount += static_cast<uint32_t>(subMesh.faces.size());
+    }
+    AppendData(data, &header, sizeof(header));
+
+    auto appendString = [&](std::string_view str) {
+        uint32_t len = static_cast<uint32_t>(str.size());
+        AppendData(data, &len, sizeof(len));
+        AppendData(data, str.data(), len);
+    };
+
+    uint32_t mtllibCount = static_cast<uint32_t>(object.mtllibs.size());
+    AppendData(data, &mtllibCount, sizeof(mtllibCount));
+    for (const auto& mtllib : object.mtllibs) appendString(mtllib);
+    AppendData(data, object.positions.data(), sizeof(XMFLOAT3) * object.positions.size());
+    AppendData(data, object.normals.data(), sizeof(XMFLOAT3) * object.normals.size());
+    AppendData(data, object.texcoords.data(), sizeof(XMFLOAT2) * object.texcoords.size());
+
+    uint32_t meshCount = static_cast<uint32_t>(object.meshes.size());
+    AppendData(data, &meshCount, sizeof(meshCount));
+    for (const auto& mesh : object.meshes)
+    {
+        appendString(mesh.name);
+        AppendData(data, &mesh.parent, sizeof(mesh.parent));
+        uint32_t subMeshCount = static_cast<uint32_t>(mesh.subMeshs.size());
+        AppendData(data, &subMeshCount, sizeof(subMeshCount));
+        for (const auto& subMesh : mesh.subMeshs)
+        {
+            appendString(subMesh.material);
+            uint32_t faceCount = static_cast<uint32_t>(subMesh.faces.size());
+            AppendData(data, &faceCount, sizeof(faceCount));
+            AppendData(data, subMesh.faces.data(), sizeof(Face) * faceCount);
+        }
+    }
+
+    // 書き込み途中のファイルを読まないように一時ファイルに書いてから置き換える
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream ofs(temp, std::ios::binary);
+        if (!ofs.write(data.data(), data.size())) return;
+    }
+    std::filesystem::rename(temp, path, ec);
+    if (ec) std::filesystem::remove(temp, ec);
+}
+
+// キャッシュのヘッダーを確認する関数（使用できない場合はfalse）
+static bool CheckObjCache(const MappedFile& cache, const ObjCacheHeader& source, ObjCacheHeader& header)
+{
+    if (cache.GetSize() < sizeof(header)) return false;
+    memcpy(&header, cache.GetData(), sizeof(header));
+    return header.magic == ObjCacheMagic && header.version == ObjCacheVersion
+        && header.sourceSize == source.sourceSize && header.sourceTime == source.sourceTime
+        && header.groups == source.groups;
+}
+
+// キャッシュから解析結果を取得する関数（壊れている場合はfalse）
+static bool LoadObjCache(const MappedFile& cache, const ObjCacheHeader& header, Object& object)
+{
+    const char* p = cache.GetData() + sizeof(header);
+    const char* end = cache.GetData() + cache.GetSize();
+
+    auto read = [&](void* dst, size_t size) {
+        if (static_cast<size_t>(end - p) < size) return false;
+        memcpy(dst, p, size);
+        p += size;
+        return true;
+    };
+
+    auto readCount = [&](uint32_t& count) {
+        return read(&count, sizeof(count));
+    };
+
+    auto readString = [&](auto& str) {
+        uint32_t len;
+        if (!readCount(len) || static_cast<size_t>(end - p) < len) return false;
+        str.assign(p, len);
+        p += len;
+        return true;
+    };
+
+    auto readArray = [&](auto& array, uint32_t count) {
+        array.resize(count);
+        return read(array.data(), sizeof(array[0]) * count);
+    };
+
+    uint32_t mtllibCount;
+    if (!readCount(mtllibCount)) return false;
+    for (uint32_t i = 0; i < mtllibCount; i++)
+    {
+        if (!readString(object.mtllibs.emplace_back())) return false;
+    }
+    if (!readArray(object.positions, header.positionCount)) return false;
+    if (!readArray(object.normals, header.normalCount)) return false;
+    if (!readArray(object.texcoords, header.texcoordCount)) return false;
+
+    uint32_t meshCount;
+    if (!readCount(meshCount)) return false;
+    object.meshes.reserve(meshCount);
+    for (uint32_t i = 0; i < meshCount; i++)
+    {
+        Mesh& mesh = object.meshes.emplace_back();
+        uint32_t subMeshCount;
+        if (!readString(mesh.name) || !read(&mesh.parent, sizeof(mesh.parent))) return false;
+        if (mesh.parent >= static_cast<int32_t>(i) || !readCount(subMeshCount)) return false;
+        mesh.subMeshs.reserve(subMeshCount);
+        for (uint32_t j = 0; j < subMeshCount; j++)
+        {
+            SubMesh& subMesh = mesh.subMeshs.emplace_back();
+            uint32_t faceCount;
+            if (!readString(subMesh.material) || !readCount(faceCount)) return false;
+            if (!readArray(subMesh.faces, faceCount)) return false;
+
+            // インデックスが範囲外の場合は壊れているとみなす（vt, vnは-1がなし）
+            for (const auto& face : subMesh.faces)
+            {
+                for (const auto& faceIndex : face.faceIndices)
+                {
+                    if (faceIndex.v < 0 || static_cast<uint32_t>(faceIndex.v) >= header.positionCount) return false;
+                    if (faceIndex.vt < -1 || faceIndex.vt >= static_cast<int64_t>(header.texcoordCount)) return false;
+                    if (faceIndex.vn < -1 || faceIndex.vn >= static_cast<int64_t>(header.normalCount)) return false;
+                }
+            }
+        }
+    }
+
+    return p == end;
+}
+
+// 範囲を分割して並列に処理する関数（少ない場合は呼び出したスレッドのみで処理する）
+static void ParallelFor(size_t count, size_t minPerTask, const std::function<void(size_t, size_t)>& func)
+{
+    size_t tasks = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), count / minPerTask);
+    if (tasks <= 1)
+    {
+        func(0, count);
+        return;
+    }
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(tasks - 1);
+    for (size_t t = 1; t < tasks; t++)
+    {
+        futures.push_back(std::async(std::launch::async, func, count * t / tasks, count * (t + 1) / tasks));
+    }
+    func(0, count / tasks);
+    for (auto& future : futures) future.get();
+}
+
+// 法線のない頂点の法線を生成する関数
+// 同じ位置を共有する同じスムージンググループの面の法線を、角の角度と面積で重み付けして平均する
+// （スムージンググループ0の面と、法線の角度がcreaseAngle（度）より大きい面とは平均しない）
+static void GenerateNormals(Object& object, float creaseAngle)
+{
+    constexpr size_t MinFacesPerTask = 4096;    // 並列に処理する場合の１タスクあたりの最小の面の数
+
+    std::vector<Face*> faces;
+    bool missing = false;
+    for (auto& mesh : object.meshes)
+    {
+        for (auto& subMesh : mesh.subMeshs)
+        {
+            for (auto& face : subMesh.faces)
+            {
+                faces.push_back(&face);
+                for (const auto& faceIndex : face.faceIndices) missing |= faceIndex.vn < 0;
+            }
+        }
+    }
+    if (!missing) return;
+
+    const size_t faceCount = faces.size();
+
+    // 面の単位法線と角の重み（頂点の法線と同じ向き）
+    std::vector<XMFLOAT3> faceNormals(faceCount);
+    std::vector<float> cornerWeights(faceCount * 3);
+    ParallelFor(faceCount, MinFacesPerTask, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; f++)
+        {
+            XMVECTOR p[3];
+            for (int k = 0; k < 3; k++) p[k] = XMLoadFloat3(&object.positions[faces[f]->faceIndices[k].v]);
+
+            XMVECTOR n = XMVector3Cross(p[2] - p[0], p[1] - p[0]);
+            float area = XMVectorGetX(XMVector3Length(n)) * 0.5f;
+            XMStoreFloat3(&faceNormals[f], XMVector3Normalize(n));
+
+            for (int k = 0; k < 3; k++)
+            {
+                XMVECTOR e1 = XMVector3Normalize(p[(k + 1) % 3] - p[k]);
+                XMVECTOR e2 = XMVector3Normalize(p[(k + 2) % 3] - p[k]);
+                float angle = std::acos(std::clamp(XMVectorGetX(XMVector3Dot(e1, e2)), -1.0f, 1.0f));
+                cornerWeights[f * 3 + k] = angle * area;
+            }
+        }
+    });
+
+    // 位置ごとの角（面の番号 * 3 + 角の番号）の一覧（位置ごとに連続して格納）
+    std::vector<uint32_t> adjacencyStart(object.positions.size() + 1, 0);
+    for (const Face* face : faces)
+    {
+        for (const auto& faceIndex : face->faceIndices) adjacencyStart[faceIndex.v + 1]++;
+    }
+    for (size_t i = 0; i < object.positions.size(); i++) adjacencyStart[i + 1] += adjacencyStart[i];
+
+    std::vector<uint32_t> adjacency(faceCount * 3);
+    std::vector<uint32_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (size_t f = 0; f < faceCount; f++)
+    {
+        for (int k = 0; k < 3; k++) adjacency[fill[faces[f]->faceIndices[k].v]++] = static_cast<uint32_t>(f * 3 + k);
+    }
+
+    // 法線のない角の法線
+    const float creaseCos = std::cos(XMConvertToRadians(creaseAngle));
+    std::vector<XMFLOAT3> cornerNormals(faceCount * 3);
+    ParallelFor(faceCount, MinFacesPerTask, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; f++)
+        {
+            const Face& face = *faces[f];
+            XMVECTOR faceNormal = XMLoadFloat3(&faceNormals[f]);
+            for (int k = 0; k < 3; k++)
+            {
+                if (face.faceIndices[k].vn >= 0) continue;
+
+                XMVECTOR n = faceNormal;
+                if (face.smoothingGroup != 0)
+                {
+                    n = XMVectorZero();
+                    int v = face.faceIndices[k].v;
+                    for (uint32_t i = adjacencyStart[v]; i < adjacencyStart[v + 1]; i++)
+                    {
+                        uint32_t other = adjacency[i] / 3;
+                        if (faces[other]->smoothingGroup != face.smoothingGroup) continue;
+                        XMVECTOR otherNormal = XMLoadFloat3(&faceNormals[other]);
+                        if (XMVectorGetX(XMVector3Dot(faceNormal, otherNormal)) < creaseCos) continue;
+                        n += otherNormal * cornerWeights[adjacency[i]];
+                    }
+                    if (XMVectorGetX(XMVector3LengthSq(n)) <= 0.0f) n = faceNormal;
+                }
+
+                // 面積のない面のみの場合はダミー
+                if (XMVectorGetX(XMVector3LengthSq(n)) <= 0.0f) n = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+                XMStoreFloat3(&cornerNormals[f * 3 + k], XMVector3Normalize(n));
+            }
+        }
+    });
+
+    // 位置ごとに同じ法線をまとめて登録する（同じ頂点として結合されるように）
+    for (size_t v = 0; v < object.positions.size(); v++)
+    {
+        size_t first = object.normals.size();
+        for (uint32_t i = adjacencyStart[v]; i < adjacencyStart[v + 1]; i++)
+        {
+            FaceIndex& faceIndex = faces[adjacency[i] / 3]->faceIndices[adjacency[i] % 3];
+            if (faceIndex.vn >= 0) continue;
+
+            const XMFLOAT3& n = cornerNormals[adjacency[i]];
+            size_t index = first;
+            while (index < object.normals.size() && memcmp(&object.normals[index], &n, sizeof(n)) != 0) index++;
+            if (index == object.normals.size()) object.normals.push_back(n);
+            faceIndex.vn = static_cast<int>(index);
+        }
+    }
+}
+
+// テクスチャの参照の取得関数（最後のトークン、ない場合は空）
+// パス名は登録する時に除去する（テクスチャの確認ではmtlファイルからの相対パスとして使う）
+static std::string ReadTextureName(std::istringstream& iss)
+{
+    // 最後のトークンをファイル名として取得
+    std::string token, name;
+    while (iss >> token)
+    {
+        name = token;
+    }
+
+    return name;
+}
+
+// mtlファイルのnewmtlごとの解析結果（テクスチャの設定先を指すのでコピーしない）
+struct MaterialBlock
+{
+    std::string name;                                   // マテリアル名
+    MaterialInfo material;                              // マテリアル（テクスチャインデックス以外）
+    MaterialInfoEx extended;                            // 拡張マテリアル（テクスチャインデックス以外）
+    std::vector<std::pair<int32_t*, std::string>> textures; // 現れた順のテクスチャの設定先とテクスチャの参照
+
+    MaterialBlock() = default;
+    MaterialBlock(const MaterialBlock&) = delete;
+    MaterialBlock& operator=(const MaterialBlock&) = delete;
+};
+
+// 行の最後の値を取得する関数（dの-haloのようなオプションを読み飛ばす）
+static float ReadLastFloat(std::istringstream& iss, float defaultValue)
+{
+    std::string token, last;
+    while (iss >> token)
+    {
+        last = token;
+    }
+    return last.empty() ? defaultValue : std::strtof(last.c_str(), nullptr);
+}
+
+// mtlファイルのnewmtlから次のnewmtlまでの解析関数
+static void AnalyzeMtlBlock(std::string_view text, MaterialBlock& block)
+{
+    MaterialInfo& material = block.material;
+    MaterialInfoEx& extended = block.extended;
+
+    // テクスチャの行と設定先
+    const std::pair<const char*, int32_t*> textureTypes[] = {
+        { "map_Kd", &material.textureIndex_BaseColor },
+        { "map_Bump", &material.textureIndex_NormalMap },
+        { "map_bump", &material.textureIndex_NormalMap },
+        { "bump", &material.textureIndex_NormalMap },
+        { "norm", &material.textureIndex_NormalMap },
+        { "map_Ka", &extended.textureIndex_Ambient },
+        { "map_Ks", &extended.textureIndex_Specular },
+        { "map_Ns", &extended.textureIndex_SpecularPower },
+        { "map_d", &extended.textureIndex_Opacity },
+        { "map_Ke", &extended.textureIndex_Emissive },
+        { "map_Pr", &extended.textureIndex_Roughness },
+        { "map_Pm", &extended.textureIndex_Metallic },
+        { "map_Ps", &extended.textureIndex_Sheen },
+        { "disp", &extended.textureIndex_Displacement },
+    };
+
+    size_t pos = 0;
+    std::string line;
+    while (GetLine(text, pos, line))
+    {
+        // 空行やコメントをスキップ
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream iss(line);
+
+        // 先頭のトークン
+        std::string type;
+        iss >> type;
+
+        // マテリアルファイル名
+        if (type == "newmtl")
+        {
+            iss >> block.name;
+        }
+
+        // ディフューズ色
+        else if (type == "Kd")
+        {
+            material.diffuseColor = ReadFloat3(iss);
+        }
+
+        // スペキュラ色
+        else if (type == "Ks")
+        {
+            material.specularColor = ReadFloat3(iss);
+        }
+
+        // スペキュラパワー
+        else if (type == "Ns")
+        {
+            iss >> material.specularPower;
+        }
+
+        // エミッシブ色
+        else if (type == "Ke")
+        {
+            material.emissiveColor = ReadFloat3(iss);
+        }
+
+        // アンビエント色
+        else if (type == "Ka")
+        {
+            extended.ambientColor = ReadFloat3(iss);
+        }
+
+        // 不透明度
+        else if (type == "d")
+        {
+            extended.opacity = ReadLastFloat(iss, 1.0f);
+        }
+
+        // 透明度
+        else if (type == "Tr")
+        {
+            extended.opacity = 1.0f - ReadLastFloat(iss, 0.0f);
+        }
+
+        // 透過フィルター
+        else if (type == "Tf")
+        {
+            extended.transmissionFilter = ReadFloat3(iss);
+        }
+
+        // 屈折率
+        else if (type == "Ni")
+        {
+            iss >> extended.refractionIndex;
+        }
+
+        // 照明モデル
+        else if (type == "illum")
+        {
+            iss >> extended.illuminationModel;
+        }
+
+        // PBRのパラメータ
+        else if (type == "Pr")
+        {
+            iss >> extended.roughness;
+            extended.flags |= MaterialFlag_Pbr;
+        }
+        else if (type == "Pm")
+        {
+            iss >> extended.metallic;
+            extended.flags |= MaterialFlag_Pbr;
+        }
+        else if (type == "Ps")
+        {
+            iss >> extended.sheen;
+        }
+        else if (type == "Pc")
+        {
+            iss >> extended.clearcoatThickness;
+        }
+        else if (type == "Pcr")
+        {
+            iss >> extended.clearcoatRoughness;
+        }
+        else if (type == "aniso")
+        {
+            iss >> extended.anisotropy;
+        }
+        else if (type == "anisor")
+        {
+            iss >> extended.anisotropyRotation;
+        }
+
+        // テクスチャ
+        else
+        {
+            for (const auto& [name, index] : textureTypes)
+            {
+                if (type != name) continue;
+                block.textures.emplace_back(index, ReadTextureName(iss));
+                if (index == &extended.textureIndex_Roughness || index == &extended.textureIndex_Metallic)
+                {
+                    extended.flags |= MaterialFlag_Pbr;
+                }
+                break;
+            }
+        }
+    }
+
+    // 半透明（不透明度のテクスチャがある場合を含む）
+    bool opacityMap = std::any_of(block.textures.begin(), block.textures.end(), [&](const auto& texture) {
+        return texture.first == &extended.textureIndex_Opacity && !texture.second.empty();
+    });
+    if (extended.opacity < 1.0f || opacityMap) extended.flags |= MaterialFlag_Transparent;
+}
+
+// mtlファイルの情報取得関数
+// newmtlごとに並列に解析してから、テクスチャ名をファイル内で現れた順に登録する
+// texturePathsにはテクスチャごとに最初に現れた参照（パス名付き）を格納する
+static int AnalyzeMtl( std::string_view text,
+                       std::vector<MaterialInfo>& materials,
+                       std::vector<MaterialInfoEx>& materialsEx,
+                       std::unordered_map<std::string, uint32_t>& materialIndexMap,
+                       std::vector<std::string>& textures,
+                       std::vector<std::string>& texturePaths )
+{
+    constexpr size_t MinBlocksPerTask = 256;    // 並列に処理する場合の１タスクあたりの最小のマテリアル数
+
+    // newmtlの行の位置（最初のnewmtlより前の行は使用しない）
+    std::vector<size_t> blockStart;
+    for (size_t pos = 0; pos < text.size(); )
+    {
+        size_t t = text.find_first_not_of(" \t", pos);
+        if (t != std::string_view::npos && text.compare(t, 6, "newmtl") == 0
+            && (t + 6 == text.size() || text[t + 6] == ' ' || text[t + 6] == '\t' || text[t + 6] == '\r' || text[t + 6] == '\n'))
+        {
+            blockStart.push_back(pos);
+        }
+
+        size_t eol = text.find('\n', pos);
+        pos = (eol == std::string_view::npos) ? text.size() : eol + 1;
+    }
+    blockStart.push_back(text.size());
+
+    std::vector<MaterialBlock> blocks(blockStart.size() - 1);
+    ParallelFor(blocks.size(), MinBlocksPerTask, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            AnalyzeMtlBlock(text.substr(blockStart[i], blockStart[i + 1] - blockStart[i]), blocks[i]);
+        }
+    });
+
+    // 既に同じテクスチャ名が登録済みの場合も考慮
+    std::unordered_map<std::string, int32_t> textureIndexMap;
+    materials.reserve(materials.size() + blocks.size());
+    materialsEx.reserve(materialsEx.size() + blocks.size());
+    for (auto& block : blocks)
+    {
+        for (const auto& [index, path] : block.textures)
+        {
+            if (path.empty())
+            {
+                *index = -1;
+                continue;
+            }
+
+            // パス名を除去
+            std::string name = GetFileNameOnly(path);
+            auto [it, inserted] = textureIndexMap.try_emplace(name, static_cast<int32_t>(textures.size()));
+
+            // 新しく挿入された
+            if (inserted)
+            {
+                textures.push_back(name);
+                texturePaths.push_back(path);
+            }
+
+            *index = it->second;
+        }
+
+        materialIndexMap[block.name] = static_cast<uint32_t>(materials.size());
+        materials.push_back(block.material);
+        materialsEx.push_back(block.extended);
+    }
+
+    return 0;
+}
+
+// 解析済みのmtlファイル
+struct MaterialLibrary
+{
+    std::vector<MaterialInfo> materials;                        // マテリアル
+    std::vector<MaterialInfoEx> materialsEx;                    // 拡張マテリアル
+    std::unordered_map<std::string, uint32_t> materialIndexMap; // マテリアル名 → マテリアルインデックス
+    std::vector<std::string> textures;                          // テクスチャ名
+    std::vector<std::string> texturePaths;                      // テクスチャの参照（mtlファイルに書かれたパス名）
+};
+
+// ------------------------------------------------------------ //
+// mtlファイルの解析結果のキャッシュ（内容のハッシュ値ごとに保存する）
+//
+// 識別子(uint32_t)                   MtlCacheMagic
+// バージョン(uint32_t)               MtlCacheVersion
+// mtlファイルの内容のハッシュ値(uint64_t)
+// mtlファイルのサイズ(uint64_t)
+// マテリアルの数(uint32_t)
+//      マテリアル(MaterialInfo * cnt)
+//      拡張マテリアル(MaterialInfoEx * cnt)
+// マテリアル名の数(uint32_t)
+//      |マテリアル名の文字数(uint32_t)   |*cnt
+//      |マテリアル名(char)               |
+//      |マテリアルインデックス(uint32_t) |
+// テクスチャ名の数(uint32_t)
+//      |テクスチャ名の文字数(uint32_t)   |*cnt
+//      |テクスチャ名(char)               |
+//      |テクスチャの参照の文字数(uint32_t)|
+//      |テクスチャの参照(char)           |
+// ------------------------------------------------------------ //
+
+constexpr uint32_t MtlCacheMagic = MakeSectionId('M', 'T', 'L', 'C');
+constexpr uint32_t MtlCacheVersion = 3;     // 形式を変更したら更新する
+
+// 同じプロセスで変換するモデルで共有するmtlファイルの解析結果
+struct MaterialCache
+{
+    // ファイルごとの解析結果（サイズと更新日時が同じ場合は読み込まずに使用する）
+    struct FileEntry
+    {
+        uint64_t size;
+        int64_t time;
+        std::shared_ptr<const MaterialLibrary> library;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<std::string, FileEntry> files;   // mtlファイル名 → 解析結果
+    std::map<std::pair<uint64_t, uint64_t>, std::shared_ptr<const MaterialLibrary>> contents;  // (ハッシュ値, サイズ) → 解析結果
+};
+
+static MaterialCache& GetMaterialCache()
+{
+    static MaterialCache cache;
+    return cache;
+}
+
+// 解析結果をキャッシュに保存する関数（失敗しても変換は続ける）
+static void SaveMtlCache(const std::string& path, uint64_t hash, uint64_t size, const MaterialLibrary& library)
+{
+    std::vector<char> data;
+
+    auto appendCount = [&](size_t count) {
+        uint32_t cnt = static_cast<uint32_t>(count);
+        AppendData(data, &cnt, sizeof(cnt));
+    };
+
+    auto appendString = [&](const std::string& str) {
+        appendCount(str.size());
+        AppendData(data, str.data(), str.size());
+    };
+
+    uint32_t header[2] = { MtlCacheMagic, MtlCacheVersion };
+    AppendData(data, header, sizeof(header));
+    AppendData(data, &hash, sizeof(hash));
+    AppendData(data, &size, sizeof(size));
+    appendCount(library.materials.size());
+    AppendData(data, library.materials.data(), sizeof(MaterialInfo) * library.materials.size());
+    AppendData(data, library.materialsEx.data(), sizeof(MaterialInfoEx) * library.materialsEx.size());
+    appendCount(library.materialIndexMap.size());
+    for (const auto& [name, index] : library.materialIndexMap)
+    {
+        appendString(name);
+        AppendData(data, &index, sizeof(index));
+    }
+    appendCount(library.textures.size());
+    for (size_t i = 0; i < library.textures.size(); i++)
+    {
+        appendString(library.textures[i]);
+        appendString(library.texturePaths[i]);
+    }
+
+    // 書き込み途中のファイルを読まないように一時ファイルに書いてから置き換える
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream ofs(temp, std::ios::binary);
+        if (!ofs.write(data.data(), data.size())) return;
+    }
+    std::filesystem::rename(temp, path, ec);
+    if (ec) std::filesystem::remove(temp, ec);
+}
+
+// キャッシュから解析結果を取得する関数（ない場合や壊れている場合はnullptr）
+static std::shared_ptr<MaterialLibrary> LoadMtlCache(const std::string& path, uint64_t hash, uint64_t size)
+{
+    MappedFile cache;
+    if (!cache.Open(path)) return nullptr;
+
+    const char* p = cache.GetData();
+    const char* end = cache.GetData() + cache.GetSize();
+
+    auto read = [&](void* dst, size_t bytes) {
+        if (static_cast<size_t>(end - p) < bytes) return false;
+        memcpy(dst, p, bytes);
+        p += bytes;
+        return true;
+    };
+
+    auto readString = [&](std::string& str) {
+        uint32_t len;
+        if (!read(&len, sizeof(len)) || static_cast<size_t>(end - p) < len) return false;
+        str.assign(p, len);
+        p += len;
+        return true;
+    };
+
+    uint32_t header[2];
+    uint64_t cacheHash, cacheSize;
+    if (!read(header, sizeof(header)) || !read(&cacheHash, sizeof(cacheHash)) || !read(&cacheSize, sizeof(cacheSize))) return nullptr;
+    if (header[0] != MtlCacheMagic || header[1] != MtlCacheVersion || cacheHash != hash || cacheSize != size) return nullptr;
+
+    auto library = std::make_shared<MaterialLibrary>();
+    uint32_t count;
+    if (!read(&count, sizeof(count)) || static_cast<size_t>(end - p) / (sizeof(MaterialInfo) + sizeof(MaterialInfoEx)) < count) return nullptr;
+    library->materials.resize(count);
+    library->materialsEx.resize(count);
+    if (!read(library->materials.data(), sizeof(MaterialInfo) * count)) return nullptr;
+    if (!read(library->materialsEx.data(), sizeof(MaterialInfoEx) * count)) return nullptr;
+
+    if (!read(&count, sizeof(count))) return nullptr;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        std::string name;
+        uint32_t index;
+        if (!readString(name) || !read(&index, sizeof(index)) || index >= library->materials.size()) return nullptr;
+        library->materialIndexMap[name] = index;
+    }
+
+    if (!read(&count, sizeof(count))) return nullptr;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (!readString(library->textures.emplace_back()) || !readString(library->texturePaths.emplace_back())) return nullptr;
+    }
+
+    if (p != end) return nullptr;
+    return library;
+}
+
+// mtlファイルの解析結果を取得する関数（同じプロセス内とcacheDirectoryのキャッシュを使用する、失敗時はnullptr）
+static std::shared_ptr<const MaterialLibrary> LoadMaterialLibrary( const std::string& path,
+                                                                   const MaterialLoader& loader,
+                                                                   const std::string& cacheDirectory )
+{
+    MaterialCache& cache = GetMaterialCache();
+
+    // ファイルから読み込む場合は、更新されていなければ前回の解析結果を使用する
+    uint64_t fileSize = 0;
+    int64_t fileTime = 0;
+    bool hasInfo = !loader && GetSourceInfo(path, fileSize, fileTime);
+    if (hasInfo)
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto it = cache.files.find(path);
+        if (it != cache.files.end() && it->second.size == fileSize && it->second.time == fileTime) return it->second.library;
+    }
+
+    // mtlファイルの内容
+    std::string text;
+    if (loader)
+    {
+        if (!loader(path, text))
+        {
+            std::cout << "Could not open " << path << std::endl;
+            return nullptr;
+        }
+    }
+    else
+    {
+        if (ReadFileText(path, text)) return nullptr;
+    }
+
+    // 同じ内容の解析結果（別のファイル名、または更新日時のみ変わった場合）
+    auto key = std::make_pair(HashData(text.data(), text.size()), static_cast<uint64_t>(text.size()));
+    std::shared_ptr<const MaterialLibrary> library;
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto it = cache.contents.find(key);
+        if (it != cache.contents.end()) library = it->second;
+    }
+
+    // ディスクのキャッシュ
+    std::string cachePath;
+    if (!library && !cacheDirectory.empty())
+    {
+        std::ostringstream name;
+        name << std::filesystem::path(path).stem().string() << "_" << std::hex << key.first << ".mtlcache";
+        cachePath = (std::filesystem::path(cacheDirectory) / name.str()).string();
+        library = LoadMtlCache(cachePath, key.first, key.second);
+    }
+
+    // mtlファイルを解析
+    if (!library)
+    {
+        auto parsed = std::make_shared<MaterialLibrary>();
+        if (AnalyzeMtl(text, parsed->materials, parsed->materialsEx, parsed->materialIndexMap, parsed->textures, parsed->texturePaths)) return nullptr;
+        if (!cachePath.empty()) SaveMtlCache(cachePath, key.first, key.second, *parsed);
+        library = parsed;
+    }
+
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.contents[key] = library;
+    if (hasInfo) cache.files[path] = { fileSize, fileTime, library };
+    return library;
+}
+
+// 拡張マテリアルのパラメータを使用しているか調べる関数
+// Ka、Tf、Ni、illumは多くのエクスポーターがすべてのマテリアルに出力するので対象にしない
+static bool UsesExtendedMaterial(const MaterialInfoEx& extended)
+{
+    const MaterialInfoEx defaults;
+    constexpr size_t first = offsetof(MaterialInfoEx, roughness);
+    constexpr size_t last = offsetof(MaterialInfoEx, flags);    // PBRのパラメータから拡張テクスチャまで
+    return extended.flags != 0
+        || memcmp(reinterpret_cast<const char*>(&extended) + first, reinterpret_cast<const char*>(&defaults) + first, last - first) != 0;
+}
+
+// マテリアルのすべてのテクスチャインデックスに対して処理を行う関数
+template <typename Func>
+static void ForEachTextureIndex(MaterialInfo& material, MaterialInfoEx& extended, Func func)
+{
+    for (int32_t* index : { &material.textureIndex_BaseColor, &material.textureIndex_NormalMap,
+                            &extended.textureIndex_Ambient, &extended.textureIndex_Specular,
+                            &extended.textureIndex_SpecularPower, &extended.textureIndex_Opacity,
+                            &extended.textureIndex_Emissive, &extended.textureIndex_Roughness,
+                            &extended.textureIndex_Metallic, &extended.textureIndex_Sheen,
+                            &extended.textureIndex_Displacement })
+    {
+        func(*index);
+    }
+}
+
+// mtlファイルの解析結果をマテリアルの末尾に追加する関数（同じ名前のテクスチャは共有し、同じ名前のマテリアルは後のものを使う）
+static void AppendMaterialLibrary( const MaterialLibrary& library,
+                                   std::vector<MaterialInfo>& materials,
+                                   std::vector<MaterialInfoEx>& materialsEx,
+                                   std::unordered_map<std::string, uint32_t>& materialIndexMap,
+                                   std::vector<std::string>& textures,
+                                   std::unordered_map<std::string, int32_t>& textureIndexMap )
+{
+    // テクスチャインデックスの置き換え表
+    std::vector<int32_t> textureRemap(library.textures.size());
+    for (size_t i = 0; i < library.textures.size(); i++)
+    {
+        auto [it, inserted] = textureIndexMap.try_emplace(library.textures[i], static_cast<int32_t>(textures.size()));
+        if (inserted) textures.push_back(library.textures[i]);
+        textureRemap[i] = it->second;
+    }
+
+    uint32_t base = static_cast<uint32_t>(materials.size());
+    for (size_t i = 0; i < library.materials.size(); i++)
+    {
+        MaterialInfo material = library.materials[i];
+        MaterialInfoEx extended = library.materialsEx[i];
+        ForEachTextureIndex(material, extended, [&](int32_t& index) {
+            if (index >= 0) index = textureRemap[index];
+        });
+        materials.push_back(material);
+        materialsEx.push_back(extended);
+    }
+
+    for (const auto& [name, index] : library.materialIndexMap)
+    {
+        materialIndexMap[name] = base + index;
+    }
+}
+
+// マテリアルの整理関数（メッシュ情報のインデックスは置き換える）
+// dedupがtrueの場合は内容が同じマテリアルを１つにまとめ、stripがtrueの場合は使用していないマテリアル、マテリアル名、テクスチャを取り除く
+static void OptimizeMaterials( bool dedup,
+                               bool strip,
+                               std::vector<MaterialInfo>& materials,
+                               std::vector<MaterialInfoEx>& materialsEx,
+                               std::vector<std::string>& materialNames,
+                               std::vector<std::string>& textures,
+                               std::vector<MeshInfo>& meshInfo )
+{
+    // 内容が同じマテリアルは最初のものを使う
+    std::vector<uint32_t> materialRemap(materials.size());
+    std::unordered_map<std::string, uint32_t> contentMap;
+    for (uint32_t i = 0; i < materials.size(); i++)
+    {
+        materialRemap[i] = i;
+        if (!dedup) continue;
+
+        std::string content(reinterpret_cast<const char*>(&materials[i]), sizeof(MaterialInfo));
+        content.append(reinterpret_cast<const char*>(&materialsEx[i]), sizeof(MaterialInfoEx));
+        materialRemap[i] = contentMap.try_emplace(std::move(content), i).first->second;
+    }
+
+    // 残すマテリアル
+    std::vector<bool> usedMaterials(materials.size(), !strip);
+    std::vector<bool> usedNames(materialNames.size(), !strip);
+    for (const auto& mesh : meshInfo)
+    {
+        usedMaterials[materialRemap[mesh.materialIndex]] = true;
+        usedNames[mesh.materialNameIndex] = true;
+    }
+
+    std::vector<uint32_t> newIndex(materials.size());
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < materials.size(); i++)
+    {
+        if (materialRemap[i] != i || !usedMaterials[i]) continue;
+        materials[count] = materials[i];
+        materialsEx[count] = materialsEx[i];
+        newIndex[i] = count++;
+    }
+    materials.resize(count);
+    materialsEx.resize(count);
+
+    // 残すマテリアル名
+    std::vector<uint32_t> newNameIndex(materialNames.size());
+    count = 0;
+    for (uint32_t i = 0; i < materialNames.size(); i++)
+    {
+        if (!usedNames[i]) continue;
+        if (count != i) materialNames[count] = std::move(materialNames[i]);
+        newNameIndex[i] = count++;
+    }
+    materialNames.resize(count);
+
+    for (auto& mesh : meshInfo)
+    {
+        mesh.materialIndex = newIndex[materialRemap[mesh.materialIndex]];
+        mesh.materialNameIndex = newNameIndex[mesh.materialNameIndex];
+    }
+
+    // 残すテクスチャ
+    if (!strip) return;
+
+    std::vector<int32_t> newTextureIndex(textures.size(), -1);
+    for (size_t i = 0; i < materials.size(); i++)
+    {
+        ForEachTextureIndex(materials[i], materialsEx[i], [&](int32_t& index) {
+            if (index >= 0) newTextureIndex[index] = 0;
+        });
+    }
+
+    int32_t textureCount = 0;
+    for (size_t i = 0; i < textures.size(); i++)
+    {
+        if (newTextureIndex[i] < 0) continue;
+        if (static_cast<size_t>(textureCount) != i) textures[textureCount] = std::move(textures[i]);
+        newTextureIndex[i] = textureCount++;
+    }
+    textures.resize(textureCount);
+
+    for (size_t i = 0; i < materials.size(); i++)
+    {
+        ForEachTextureIndex(materials[i], materialsEx[i], [&](int32_t& index) {
+            if (index >= 0) index = newTextureIndex[index];
+        });
+    }
+}
+
+// メッシュ情報を描画ステートの順に並べ替える関数（インデックスの範囲もその順に並べ直す）
+// 不透明、法線マップなし、ベースカラーテクスチャ、マテリアルの順に比較し、ノードがある場合はノードの中だけで並べ替える
+static void SortMeshes( const std::vector<MaterialInfo>& materials,
+                        const std::vector<MaterialInfoEx>& materialsEx,
+                        const std::vector<NodeInfo>& nodes,
+                        std::vector<MeshInfo>& meshInfo,
+                        std::vector<uint16_t>& indexBuffer,
+                        std::vector<BoundingVolume>& meshBounds,
+                        std::vector<ObjectRange>& objectRanges )
+{
+    auto stateKey = [&](const MeshInfo& mesh) {
+        const MaterialInfo& material = materials[mesh.materialIndex];
+        bool transparent = (materialsEx[mesh.materialIndex].flags & MaterialFlag_Transparent) != 0;
+        return std::make_tuple(transparent, material.textureIndex_NormalMap >= 0, material.textureIndex_BaseColor, mesh.materialIndex);
+    };
+
+    // 並べ替える範囲
+    std::vector<std::pair<uint32_t, uint32_t>> spans;
+    if (nodes.empty())
+    {
+        spans.emplace_back(0, static_cast<uint32_t>(meshInfo.size()));
+    }
+    for (const auto& node : nodes)
+    {
+        spans.emplace_back(node.meshStart, node.meshStart + node.meshCount);
+    }
+
+    std::vector<uint32_t> order(meshInfo.size());
+    for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+    for (const auto& [begin, end] : spans)
+    {
+        std::stable_sort(order.begin() + begin, order.begin() + end, [&](uint32_t a, uint32_t b) {
+            return stateKey(meshInfo[a]) < stateKey(meshInfo[b]);
+        });
+    }
+
+    // 新しい順にメッシュ情報、インデックス、境界ボリュームを並べる
+    std::vector<MeshInfo> sortedMeshInfo;
+    std::vector<uint16_t> sortedIndices;
+    std::vector<BoundingVolume> sortedBounds;
+    std::vector<uint32_t> newIndex(meshInfo.size());
+    sortedMeshInfo.reserve(meshInfo.size());
+    sortedIndices.reserve(indexBuffer.size());
+    sortedBounds.reserve(meshBounds.size());
+    for (uint32_t i = 0; i < order.size(); i++)
+    {
+        MeshInfo mesh = meshInfo[order[i]];
+        auto first = indexBuffer.begin() + mesh.startIndex;
+        mesh.startIndex = static_cast<uint32_t>(sortedIndices.size());
+        sortedIndices.insert(sortedIndices.end(), first, first + mesh.primCount * 3);
+        sortedMeshInfo.push_back(mesh);
+        sortedBounds.push_back(meshBounds[order[i]]);
+        newIndex[order[i]] = i;
+    }
+    meshInfo = std::move(sortedMeshInfo);
+    indexBuffer = std::move(sortedIndices);
+    meshBounds = std::move(sortedBounds);
+
+    // オブジェクトごとの範囲はメッシュ情報の先頭からの位置なので番号だけ置き換える
+    for (auto& range : objectRanges)
+    {
+        range.meshInfoIndex = newIndex[range.meshInfoIndex];
+    }
+    std::stable_sort(objectRanges.begin(), objectRanges.end(), [](const ObjectRange& a, const ObjectRange& b) {
+        return a.meshInfoIndex < b.meshInfoIndex;
+    });
+}
+
+// テクスチャのファイルを確認する関数（見つからないか壊れているテクスチャのパス名をproblemsに格納する）
+// 画像全体は読まずにヘッダーのみを並列に読み込む
+static void CheckTextures( const std::vector<std::string>& textures,
+                           const std::unordered_map<std::string, std::string>& texturePaths,
+                           std::vector<std::string>& problems )
+{
+    // テクスチャごとの結果（0:正常、1:見つからない、2:壊れている）
+    std::vector<int> status(textures.size(), 0);
+    std::vector<std::string> paths(textures.size());
+    ParallelFor(textures.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            auto it = texturePaths.find(textures[i]);
+            paths[i] = (it != texturePaths.end()) ? it->second : textures[i];
+
+            ImageHeader header;
+            if (!ReadImageHeader(paths[i], header)) status[i] = 1;
+            else if (header.format && (header.width == 0 || header.height == 0)) status[i] = 2;
+        }
+    });
+
+    // テクスチャの順に表示する
+    for (size_t i = 0; i < textures.size(); i++)
+    {
+        if (status[i] == 0) continue;
+        std::cout << (status[i] == 1 ? "Texture not found: " : "Invalid texture: ") << paths[i] << std::endl;
+        problems.push_back(paths[i]);
+    }
+}
+
+// 頂点データ作成関数
+static VertexPositionNormalTextureTangent MakeVertex(Object& object, const FaceIndex& face)
+{
+    VertexPositionNormalTextureTangent v = {};
+
+    v.position = object.positions[face.v];
+
+    if (face.vn >= 0)
+    {
+        // 法線を正規化
+        XMVECTOR n = XMLoadFloat3(&object.normals[face.vn]);
+        n = XMVector3Normalize(n);
+        XMStoreFloat3(&v.normal, n);
+    }
+    else
+    {
+        // ダミー
+        v.normal = XMFLOAT3(0.0f, 0.0f, 1.0f);
+    }
+
+    v.texcoord = (face.vt >= 0) ? object.texcoords[face.vt] : XMFLOAT2(0.0f, 0.0f);
+
+    return v;
+}
+
+// 境界ボリュームを求める関数（indicesがnullptrの場合は頂点を順に使う）
+static BoundingVolume ComputeBounds(const std::vector<VertexPositionNormalTextureTangent>& vertices,
+                                    const uint16_t* indices, size_t count)
+{
+    BoundingVolume bounds = {};
+    if (count == 0) return bounds;
+
+    auto position = [&](size_t i) {
+        return XMLoadFloat3(&vertices[indices ? indices[i] : i].position);
+    };
+
+    // 軸平行境界ボックス
+    XMVECTOR vmin = position(0);
+    XMVECTOR vmax = vmin;
+    for (size_t i = 1; i < count; i++)
+    {
+        XMVECTOR p = position(i);
+        vmin = XMVectorMin(vmin, p);
+        vmax = XMVectorMax(vmax, p);
+    }
+    XMStoreFloat3(&bounds.aabbMin, vmin);
+    XMStoreFloat3(&bounds.aabbMax, vmax);
+
+    // 境界球（中心は境界ボックスの中心、半径は最も遠い頂点までの距離）
+    XMVECTOR center = (vmin + vmax) * 0.5f;
+    XMVECTOR radiusSq = XMVectorZero();
+    for (size_t i = 0; i < count; i++)
+    {
+        radiusSq = XMVectorMax(radiusSq, XMVector3LengthSq(position(i) - center));
+    }
+    XMStoreFloat3(&bounds.center, center);
+    bounds.radius = std::sqrt(XMVectorGetX(radiusSq));
+
+    return bounds;
+}
+
+// ノード情報を作成する関数
+// instancingがtrueの場合は移動量を除いて形状が同じノードを最初のノードの参照にして、そのサブメッシュを取り除く
+static void CreateNodes( Object& object,
+                         bool instancing,
+                         std::vector<NodeInfo>& nodes,
+                         std::vector<std::string>& nodeNames )
+{
+    // 移動量を除いた形状（ノード内で結合した頂点とインデックス）
+    struct Shape
+    {
+        XMFLOAT3 origin;                                            // 位置の最小値
+        float tolerance;                                            // 位置の許容誤差
+        std::vector<VertexPositionNormalTextureTangent> vertices;   // 位置はoriginからの相対位置
+        std::vector<uint32_t> indices;
+    };
+
+    auto makeShape = [&](const Mesh& mesh, Shape& shape) {
+        std::unordered_map<FaceIndex, uint32_t> indexMap;
+        XMVECTOR vmin = XMVectorReplicate(FLT_MAX);
+        XMVECTOR vmax = XMVectorReplicate(-FLT_MAX);
+        for (const auto& subMesh : mesh.subMeshs)
+        {
+            for (const auto& face : subMesh.faces)
+            {
+                for (const auto& faceIndex : face.faceIndices)
+                {
+                    auto [it, inserted] = indexMap.try_emplace(faceIndex, static_cast<uint32_t>(shape.vertices.size()));
+                    if (inserted)
+                    {
+                        shape.vertices.push_back(MakeVertex(object, faceIndex));
+                        XMVECTOR p = XMLoadFloat3(&shape.vertices.back().position);
+                        vmin = XMVectorMin(vmin, p);
+                        vmax = XMVectorMax(vmax, p);
+                    }
+                    shape.indices.push_back(it->second);
+                }
+            }
+        }
+        XMStoreFloat3(&shape.origin, vmin);
+        shape.tolerance = std::max(1.0f, XMVectorGetX(XMVector3Length(vmax - vmin))) * 1.0e-5f;
+        for (auto& v : shape.vertices)
+        {
+            XMStoreFloat3(&v.position, XMLoadFloat3(&v.position) - vmin);
+        }
+    };
+
+    // 位置以外（マテリアル、インデックス、法線、テクスチャ座標）のハッシュ値（FNV-1a）
+    auto hashShape = [](const Mesh& mesh, const Shape& shape) {
+        uint64_t hash = HashData(nullptr, 0);
+        auto append = [&](const void* data, size_t size) {
+            hash = HashData(data, size, hash);
+        };
+        for (const auto& subMesh : mesh.subMeshs)
+        {
+            append(subMesh.material.data(), subMesh.material.size() + 1);
+            uint32_t faceCount = static_cast<uint32_t>(subMesh.faces.size());
+            append(&faceCount, sizeof(faceCount));
+        }
+        append(shape.indices.data(), sizeof(uint32_t) * shape.indices.size());
+        for (const auto& v : shape.vertices)
+        {
+            append(&v.normal, sizeof(v.normal));
+            append(&v.texcoord, sizeof(v.texcoord));
+        }
+        return hash;
+    };
+
+    auto sameShape = [](const Mesh& a, const Shape& sa, const Mesh& b, const Shape& sb) {
+        if (a.subMeshs.size() != b.subMeshs.size() || sa.indices != sb.indices || sa.vertices.size() != sb.vertices.size()) return false;
+        for (size_t i = 0; i < a.subMeshs.size(); i++)
+        {
+            if (a.subMeshs[i].material != b.subMeshs[i].material || a.subMeshs[i].faces.size() != b.subMeshs[i].faces.size()) return false;
+        }
+        float tolerance = std::max(sa.tolerance, sb.tolerance);
+        for (size_t i = 0; i < sa.vertices.size(); i++)
+        {
+            const auto& va = sa.vertices[i];
+            const auto& vb = sb.vertices[i];
+            if (memcmp(&va.normal, &vb.normal, sizeof(va.normal)) != 0 || memcmp(&va.texcoord, &vb.texcoord, sizeof(va.texcoord)) != 0) return false;
+            XMVECTOR d = XMVectorAbs(XMLoadFloat3(&va.position) - XMLoadFloat3(&vb.position));
+            if (!XMVector3LessOrEqual(d, XMVectorReplicate(tolerance))) return false;
+        }
+        return true;
+    };
+
+    nodes.reserve(nodes.size() + object.meshes.size());
+    nodeNames.reserve(nodeNames.size() + object.meshes.size());
+
+    size_t firstNode = nodes.size();
+    std::unordered_map<uint64_t, std::vector<uint32_t>> shapeMap;  // ハッシュ値ごとの共有されるノード
+    std::vector<Shape> shapes(object.meshes.size());
+    uint32_t meshStart = 0;
+    for (uint32_t i = 0; i < object.meshes.size(); i++)
+    {
+        Mesh& mesh = object.meshes[i];
+
+        NodeInfo node = {};
+        node.parent = mesh.parent;
+        node.meshStart = meshStart;
+        node.meshCount = static_cast<uint32_t>(mesh.subMeshs.size());
+        node.instanceOf = i;
+
+        // 面がないノードは共有しない
+        bool hasFaces = std::any_of(mesh.subMeshs.begin(), mesh.subMeshs.end(),
+                                    [](const SubMesh& subMesh) { return !subMesh.faces.empty(); });
+        if (instancing && hasFaces)
+        {
+            makeShape(mesh, shapes[i]);
+            auto& candidates = shapeMap[hashShape(mesh, shapes[i])];
+            auto it = std::find_if(candidates.begin(), candidates.end(), [&](uint32_t j) {
+                return sameShape(object.meshes[j], shapes[j], mesh, shapes[i]);
+            });
+            if (it != candidates.end())
+            {
+                // 形状を共有するノードのメッシュ情報を参照して、自分のサブメッシュは出力しない
+                const NodeInfo& shared = nodes[firstNode + *it];
+                node.meshStart = shared.meshStart;
+                node.meshCount = shared.meshCount;
+                node.instanceOf = *it;
+                XMStoreFloat3(&node.translation, XMLoadFloat3(&shapes[i].origin) - XMLoadFloat3(&shapes[*it].origin));
+                mesh.subMeshs.clear();
+                shapes[i] = {};
+            }
+            else
+            {
+                candidates.push_back(i);
+            }
+        }
+
+        meshStart += static_cast<uint32_t>(mesh.subMeshs.size());
+        nodes.push_back(node);
+        nodeNames.emplace_back(mesh.name);
+    }
+}
+
+static void CreateBufferData( Object& object, 
+                              std::unordered_map<std::string, uint32_t>& materialIndexMap,
+                              bool mergeMaterials,
+                              std::vector<MeshInfo>& meshInfo,
+                              std::vector<VertexPositionNormalTextureTangent>& vertexBuffer,
+                              std::vector<uint16_t>& indexBuffer,
+                              std::vector<ObjectRange>& objectRanges,
+                              BoundingVolume& modelBounds,
+                              std::vector<BoundingVolume>& meshBounds )
+{
+    std::pmr::memory_resource* resource = object.positions.get_allocator().resource();
+
+    // サブメッシュと面の数を数えてバッファを予約
+    size_t subMeshCount = 0;
+    size_t faceCount = 0;
+    for (auto& mesh : object.meshes)
+    {
+        subMeshCount += mesh.subMeshs.size();
+        for (auto& subMesh : mesh.subMeshs)
+        {
+            faceCount += subMesh.faces.size();
+        }
+    }
+    meshInfo.reserve(meshInfo.size() + subMeshCount);
+    indexBuffer.reserve(indexBuffer.size() + faceCount * 3);
+    objectRanges.reserve(objectRanges.size() + subMeshCount);
+
+    // メッシュ情報ごとのサブメッシュ（マテリアルをまとめる場合は同じマテリアルのサブメッシュを最初に現れた順に並べる）
+    std::vector<std::vector<std::pair<uint32_t, const SubMesh*>>> groups;
+    groups.reserve(subMeshCount);
+    std::unordered_map<std::string_view, size_t> groupMap;
+    for (uint32_t i = 0; i < object.meshes.size(); i++)
+    {
+        for (const auto& subMesh : object.meshes[i].subMeshs)
+        {
+            size_t group = groups.size();
+            if (mergeMaterials)
+            {
+                group = groupMap.try_emplace(std::string_view(subMesh.material), groups.size()).first->second;
+            }
+            if (group == groups.size()) groups.emplace_back();
+            groups[group].emplace_back(i, &subMesh);
+        }
+    }
+
+    // 頂点の結合（頂点数が確定するまでは頂点の構成インデックスのみ保持する）
+    std::pmr::unordered_map<FaceIndex, uint16_t> indexMap(resource);
+    std::pmr::vector<FaceIndex> vertices(resource);
+    indexMap.reserve(faceCount * 3);
+    vertices.reserve(faceCount * 3);
+    size_t baseVertex = vertexBuffer.size();
+
+    size_t firstMesh = meshInfo.size();
+    for (const auto& group : groups)
+    {
+        // サブメッシュ情報
+        MeshInfo data = {};
+        std::string material(group.front().second->material);
+        auto it = materialIndexMap.find(material);
+        if (it == materialIndexMap.end()) throw std::runtime_error("Material not found: " + material);
+        data.materialIndex = it->second;                                // マテリアルインデックス
+        data.materialNameIndex = it->second;                            // マテリアル名インデックス
+        data.startIndex = static_cast<uint32_t>(indexBuffer.size());    // スタートインデックス
+
+        for (const auto& [objectIndex, subMesh] : group)
+        {
+            // オブジェクトごとの範囲
+            ObjectRange range = {};
+            range.objectIndex = objectIndex;
+            range.meshInfoIndex = static_cast<uint32_t>(meshInfo.size());
+            range.firstPrim = static_cast<uint32_t>((indexBuffer.size() - data.startIndex) / 3);
+            range.primCount = static_cast<uint32_t>(subMesh->faces.size());
+            objectRanges.push_back(range);
+
+            for (auto& face : subMesh->faces)
+            {
+                for (int i = 0; i < 3; i++)
+                {
+                    auto [it, inserted] = indexMap.try_emplace(face.faceIndices[i], static_cast<uint16_t>(baseVertex + vertices.size()));
+
+                    if (inserted)
+                    {
+                        // 新規頂点（0xFFFFはストリップの再開インデックスに使うので頂点には割り当てない）
+                        if (baseVertex + vertices.size() >= UINT16_MAX) throw std::runtime_error("Too many vertices (max 65535)");
+                        vertices.push_back(face.faceIndices[i]);
+                    }
+
+                    indexBuffer.push_back(it->second);
+                }
+            }
+        }
+
+        data.primCount = static_cast<uint32_t>((indexBuffer.size() - data.startIndex) / 3);   // プリミティブ数
+        meshInfo.push_back(data);
+    }
+
+    // 頂点データの作成
+    vertexBuffer.reserve(vertexBuffer.size() + vertices.size());
+    for (const auto& vertex : vertices)
+    {
+        vertexBuffer.push_back(MakeVertex(object, vertex));
+    }
+
+    // 境界ボリュームの作成
+    modelBounds = ComputeBounds(vertexBuffer, nullptr, vertexBuffer.size());
+    meshBounds.reserve(meshBounds.size() + meshInfo.size() - firstMesh);
+    for (size_t i = firstMesh; i < meshInfo.size(); i++)
+    {
+        meshBounds.push_back(ComputeBounds(vertexBuffer, &indexBuffer[meshInfo[i].startIndex], meshInfo[i].primCount * 3));
+    }
+}
+
+// mdl形式への出力関数
+static void OutputMdl( std::vector<char>& out,
+                       std::vector<MaterialInfo>& materials,
+                       std::vector<MeshInfo>& meshInfo,
+                       std::vector<std::string>& materialNames,
+                       std::vector<std::string>& textures,
+                       std::vector<VertexPositionNormalTextureTangent>& vertexBuffer,
+                       std::vector<uint16_t>& indexBuffer,
+                       std::vector<Section>& sections )
+{
+    auto write = [&](const void* data, size_t size) {
+        AppendData(out, data, size);
+    };
+
+    // テクスチャ
+    uint32_t texture_cnt = static_cast<uint32_t>(textures.size());
+    write(&texture_cnt, sizeof(texture_cnt));
+    for (const auto& texture : textures)
+    {
+        uint32_t size = static_cast<uint32_t>(texture.size());
+        write(&size, sizeof(size));
+        write(texture.data(), size);
+    }
+
+    // マテリアル名テーブル
+    uint32_t materialName_cnt = static_cast<uint32_t>(materialNames.size());
+    write(&materialName_cnt, sizeof(materialName_cnt));
+    for (const auto& name : materialNames)
+    {
+        uint32_t len = static_cast<uint32_t>(name.size());
+        write(&len, sizeof(len));
+        write(name.data(), len);
+    }
+
+    // マテリアル
+    uint32_t material_cnt = static_cast<uint32_t>(materials.size());
+    write(&material_cnt, sizeof(material_cnt));
+    write(materials.data(), sizeof(MaterialInfo) * material_cnt);
+
+    // メッシュ情報
+    uint32_t mesh_cnt = static_cast<uint32_t>(meshInfo.size());
+    write(&mesh_cnt, sizeof(mesh_cnt));
+    write(meshInfo.data(), sizeof(MeshInfo) * mesh_cnt);
+
+    // インデックス
+    uint32_t index_cnt = static_cast<uint32_t>(indexBuffer.size());
+    write(&index_cnt, sizeof(index_cnt));
+    write(indexBuffer.data(), sizeof(uint16_t) * index_cnt);
+
+    // 頂点
+    uint32_t vertex_cnt = static_cast<uint32_t>(vertexBuffer.size());
+    write(&vertex_cnt, sizeof(vertex_cnt));
+    write(vertexBuffer.data(), sizeof(VertexPositionNormalTextureTangent) * vertex_cnt);
+
+    // 拡張セクション
+    for (const auto& section : sections)
+    {
+        uint32_t size = static_cast<uint32_t>(section.data.size());
+        write(&section.id, sizeof(section.id));
+        write(&size, sizeof(size));
+        write(section.data.data(), size);
+    }
+}
+
+// セクションの圧縮関数（圧縮後のサイズが元のサイズ * ratio以下になるセクションのみ置き換える）
+static void CompressSections(uint32_t codec, float ratio, std::vector<Section>& sections)
+{
+    std::vector<char> wrapped;
+    for (auto& section : sections)
+    {
+        if (section.data.empty()) continue;
+        if (section.id == SectionId_ChunkData) continue;    // チャンクごとに読み込めるように圧縮しない
+        if (!WrapSection(section.id, codec, section.data.data(), section.data.size(), wrapped)) continue;
+        if (wrapped.size() > section.data.size() * static_cast<double>(ratio)) continue;
+
+        section.id = SectionId_Compressed;
+        section.data.swap(wrapped);
+    }
+}
+
+// LODの作成関数（簡略化したインデックスはインデックスバッファの末尾に追加する）
+static void CreateLods( const ConvertOptions& options,
+                        const std::vector<VertexPositionNormalTextureTangent>& vertexBuffer,
+                        const std::vector<MeshInfo>& meshInfo,
+                        std::vector<uint16_t>& indexBuffer,
+                        std::vector<Section>& sections )
+{
+    uint32_t levelCount = options.lodLevels;
+    std::vector<LodInfo> lods;
+    lods.reserve(meshInfo.size() * levelCount);
+
+    std::vector<std::vector<uint16_t>> levels;
+    std::vector<float> errors;
+
+    for (const auto& mesh : meshInfo)
+    {
+        // レベルごとの目標の三角形数
+        std::vector<size_t> targets(levelCount);
+        double count = mesh.primCount;
+        for (uint32_t level = 0; level < levelCount; level++)
+        {
+            count *= options.lodRatio;
+            targets[level] = static_cast<size_t>(count);
+        }
+
+        // インデックスバッファは追加で再確保されるのでコピーしてから簡略化する
+        std::vector<uint16_t> source(indexBuffer.begin() + mesh.startIndex, indexBuffer.begin() + mesh.startIndex + mesh.primCount * 3);
+        SimplifyMesh(vertexBuffer, source.data(), source.size(), targets, levels, errors);
+
+        for (uint32_t level = 0; level < levelCount; level++)
+        {
+            LodInfo lod = {};
+            lod.startIndex = static_cast<uint32_t>(indexBuffer.size());
+            lod.primCount = static_cast<uint32_t>(levels[level].size() / 3);
+            lod.error = errors[level];
+            lods.push_back(lod);
+
+            indexBuffer.insert(indexBuffer.end(), levels[level].begin(), levels[level].end());
+        }
+    }
+
+    Section section = { SectionId_Lod };
+    AppendData(section.data, &levelCount, sizeof(levelCount));
+    AppendData(section.data, lods.data(), sizeof(LodInfo) * lods.size());
+    sections.push_back(std::move(section));
+}
+
+// メッシュレットの作成関数（メッシュ情報ごとに分割する）
+static void CreateMeshlets( const ConvertOptions& options,
+                            const std::vector<VertexPositionNormalTextureTangent>& vertexBuffer,
+                            const std::vector<MeshInfo>& meshInfo,
+                            const std::vector<uint16_t>& indexBuffer,
+                            std::vector<Section>& sections )
+{
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshletRange> ranges;
+    std::vector<uint16_t> meshletVertices;
+    std::vector<uint8_t> meshletTriangles;
+    ranges.reserve(meshInfo.size());
+
+    for (const auto& mesh : meshInfo)
+    {
+        MeshletRange range = {};
+        range.firstMeshlet = static_cast<uint32_t>(meshlets.size());
+        BuildMeshlets(vertexBuffer, indexBuffer.data() + mesh.startIndex, mesh.primCount * 3,
+                      options.meshletMaxVertices, options.meshletMaxTriangles,
+                      meshlets, meshletVertices, meshletTriangles);
+        range.meshletCount = static_cast<uint32_t>(meshlets.size()) - range.firstMeshlet;
+        ranges.push_back(range);
+    }
+
+    uint32_t meshletCount = static_cast<uint32_t>(meshlets.size());
+    uint32_t vertexCount = static_cast<uint32_t>(meshletVertices.size());
+    uint32_t triangleCount = static_cast<uint32_t>(meshletTriangles.size() / 3);
+
+    // 後続のデータが4バイト境界に並ぶように頂点インデックスを偶数個にする
+    if (meshletVertices.size() % 2) meshletVertices.push_back(0);
+
+    Section section = { SectionId_Meshlet };
+    AppendData(section.data, &meshletCount, sizeof(meshletCount));
+    AppendData(section.data, meshlets.data(), sizeof(Meshlet) * meshlets.size());
+    AppendData(section.data, ranges.data(), sizeof(MeshletRange) * ranges.size());
+    AppendData(section.data, &vertexCount, sizeof(vertexCount));
+    AppendData(section.data, meshletVertices.data(), sizeof(uint16_t) * meshletVertices.size());
+    AppendData(section.data, &triangleCount, sizeof(triangleCount));
+    AppendData(section.data, meshletTriangles.data(), meshletTriangles.size());
+    sections.push_back(std::move(section));
+}
+
+// BVHの作成関数（すべてのメッシュ情報の三角形をまとめて対象にする）
+static void CreateBvh( const std::vector<VertexPositionNormalTextureTangent>& vertexBuffer,
+                       const std::vector<MeshInfo>& meshInfo,
+                       const std::vector<uint16_t>& indexBuffer,
+                       std::vector<Section>& sections )
+{
+    // メッシュ情報の範囲はインデックス情報の先頭から連続している
+    size_t indexCount = 0;
+    for (const auto& mesh : meshInfo)
+    {
+        indexCount = std::max(indexCount, static_cast<size_t>(mesh.startIndex) + mesh.primCount * 3);
+    }
+
+    std::vector<BvhNode> nodes;
+    std::vector<uint32_t> primitives;
+    BuildBvh(vertexBuffer, indexBuffer.data(), indexCount / 3, nodes, primitives);
+
+    uint32_t nodeCount = static_cast<uint32_t>(nodes.size());
+    uint32_t primitiveCount = static_cast<uint32_t>(primitives.size());
+
+    Section section = { SectionId_Bvh };
+    AppendData(section.data, &nodeCount, sizeof(nodeCount));
+    AppendData(section.data, nodes.data(), sizeof(BvhNode) * nodes.size());
+    AppendData(section.data, &primitiveCount, sizeof(primitiveCount));
+    AppendData(section.data, primitives.data(), sizeof(uint32_t) * primitives.size());
+    sections.push_back(std::move(section));
+}
+
+// チャンクの作成関数（メッシュ情報とLODのレベルごとに頂点情報とインデックス情報を分ける）
+static void CreateChunks( const std::vector<VertexPositionNormalTextureTangent>& vertexBuffer,
+                          std::vector<MeshInfo>& meshInfo,
+                          const std::vector<uint16_t>& indexBuffer,
+                          std::vector<Section>& sections )
+{
+    // LODセクションがあればLOD情報も対象にする
+    uint32_t levelCount = 0;
+    LodInfo* lods = nullptr;
+    for (auto& section : sections)
+    {
+        if (section.id != SectionId_Lod) continue;
+        memcpy(&levelCount, section.data.data(), sizeof(levelCount));
+        lods = reinterpret_cast<LodInfo*>(section.data.data() + sizeof(levelCount));
+    }
+
+    std::vector<ChunkInfo> chunks;
+    chunks.reserve(meshInfo.size() * (levelCount + 1));
+    Section data = { SectionId_ChunkData };
+    std::vector<int> localIndex(vertexBuffer.size(), -1);
+    std::vector<uint16_t> vertices;
+    std::vector<uint16_t> indices;
+
+    auto addChunk = [&](uint32_t meshIndex, uint32_t level, uint32_t& startIndex, uint32_t primCount) {
+        // チャンク内で使用する頂点に番号を振り直す
+        vertices.clear();
+        indices.clear();
+        for (uint32_t i = 0; i < primCount * 3; i++)
+        {
+            uint16_t v = indexBuffer[startIndex + i];
+            if (localIndex[v] < 0)
+            {
+                localIndex[v] = static_cast<int>(vertices.size());
+                vertices.push_back(v);
+            }
+            indices.push_back(static_cast<uint16_t>(localIndex[v]));
+        }
+        for (auto v : vertices) localIndex[v] = -1;
+        if (indices.size() % 2) indices.push_back(0);
+
+        ChunkInfo chunk = {};
+        chunk.meshIndex = meshIndex;
+        chunk.lodLevel = level;
+        chunk.offset = static_cast<uint32_t>(data.data.size());
+        chunk.vertexCount = static_cast<uint32_t>(vertices.size());
+        chunk.indexCount = primCount * 3;
+
+        for (auto v : vertices)
+        {
+            AppendData(data.data, &vertexBuffer[v], sizeof(VertexPositionNormalTextureTangent));
+        }
+        AppendData(data.data, indices.data(), sizeof(uint16_t) * indices.size());
+        chunk.size = static_cast<uint32_t>(data.data.size()) - chunk.offset;
+        chunks.push_back(chunk);
+
+        startIndex = 0;
+    };
+
+    for (uint32_t i = 0; i < meshInfo.size(); i++)
+    {
+        addChunk(i, 0, meshInfo[i].startIndex, meshInfo[i].primCount);
+        for (uint32_t level = 0; level < levelCount; level++)
+        {
+            LodInfo& lod = lods[i * levelCount + level];
+            addChunk(i, level + 1, lod.startIndex, lod.primCount);
+        }
+    }
+
+    uint32_t chunkCount = static_cast<uint32_t>(chunks.size());
+    Section table = { SectionId_ChunkTable };
+    AppendData(table.data, &chunkCount, sizeof(chunkCount));
+    AppendData(table.data, chunks.data(), sizeof(ChunkInfo) * chunks.size());
+    sections.push_back(std::move(table));
+    sections.push_back(std::move(data));
+}
+
+// メッシュ情報ごとにストリップに変換する関数（三角形リストより小さくなる場合のみ）
+static void CreateStrips( std::vector<MeshInfo>& meshInfo,
+                          std::vector<uint16_t>& indexBuffer,
+                          std::vector<Section>& sections )
+{
+    std::vector<MeshTopology> topologies(meshInfo.size());
+    std::vector<uint16_t> indices;
+    indices.reserve(indexBuffer.size());
+    std::vector<uint16_t> strips;
+
+    // メッシュ情報の範囲はインデックス情報の先頭から連続している（LODはその後）
+    size_t listEnd = 0;
+    for (size_t i = 0; i < meshInfo.size(); i++)
+    {
+        MeshInfo& mesh = meshInfo[i];
+        const uint16_t* list = &indexBuffer[mesh.startIndex];
+        size_t count = mesh.primCount * 3;
+        listEnd = std::max(listEnd, static_cast<size_t>(mesh.startIndex) + count);
+
+        MeshTopology& topology = topologies[i];
+        topology.topology = Topology_TriangleList;
+
+        // 再開のインデックスと同じ番号の頂点を使う場合はストリップにできない
+        if (std::find(list, list + count, StripRestartIndex) == list + count)
+        {
+            BuildStrips(list, count, strips);
+            if (strips.size() < count) topology.topology = Topology_TriangleStrip;
+        }
+
+        mesh.startIndex = static_cast<uint32_t>(indices.size());
+        if (topology.topology == Topology_TriangleStrip)
+        {
+            indices.insert(indices.end(), strips.begin(), strips.end());
+        }
+        else
+        {
+            indices.insert(indices.end(), list, list + count);
+        }
+        topology.indexCount = static_cast<uint32_t>(indices.size()) - mesh.startIndex;
+    }
+
+    // LODのインデックスを移動
+    int64_t delta = static_cast<int64_t>(indices.size()) - static_cast<int64_t>(listEnd);
+    indices.insert(indices.end(), indexBuffer.begin() + listEnd, indexBuffer.end());
+    indexBuffer.swap(indices);
+
+    for (auto& section : sections)
+    {
+        if (section.id != SectionId_Lod) continue;
+
+        uint32_t levelCount;
+        memcpy(&levelCount, section.data.data(), sizeof(levelCount));
+        LodInfo* lods = reinterpret_cast<LodInfo*>(section.data.data() + sizeof(levelCount));
+        for (size_t i = 0; i < meshInfo.size() * levelCount; i++)
+        {
+            lods[i].startIndex = static_cast<uint32_t>(lods[i].startIndex + delta);
+        }
+    }
+
+    Section section = { SectionId_Topology };
+    AppendData(section.data, topologies.data(), sizeof(MeshTopology) * topologies.size());
+    sections.push_back(std::move(section));
+}
+
+// パス名を取得する関数
+static std::string GetDirectoryPath(const std::string& filepath)
+{
+    std::filesystem::path p(filepath);
+    return p.parent_path().string();
+}
+
+// パス名とファイル名を結合する関数
+static std::string JoinPath(const std::string& path, const std::string& filename)
+{
+    std::filesystem::path p(path);
+    p /= filename;   // パス結合
+    return p.string();
+}
+
+// 頂点データに接線を追加する関数
+static void GenerateTangents(
+    std::vector<VertexPositionNormalTextureTangent>& vertices,
+    const std::vector<uint16_t>& indices)
+{
+    std::vector<XMFLOAT3> tanAccum(vertices.size(), { 0,0,0 });
+    std::vector<XMFLOAT3> bitanAccum(vertices.size(), { 0,0,0 });
+
+    auto add = [&](uint32_t idx, const XMFLOAT3& t, const XMFLOAT3& b)
+        {
+            tanAccum[idx].x += t.x;
+            tanAccum[idx].y += t.y;
+            tanAccum[idx].z += t.z;
+
+            bitanAccum[idx].x += b.x;
+            bitanAccum[idx].y += b.y;
+            bitanAccum[idx].z += b.z;
+        };
+
+    auto set = [&](uint32_t idx, const XMFLOAT3& t, const XMFLOAT3& b)
+        {
+            tanAccum[idx] = t;
+            bitanAccum[idx] = b;
+        };
+
+    // 三角形の各頂点の法線が同じ向きならフラットシェーディングの面と判定
+    auto isFlatFace = [&](uint32_t i0, uint32_t i1, uint32_t i2)
+        {
+            XMVECTOR n0 = XMLoadFloat3(&vertices[i0].normal);
+            XMVECTOR n1 = XMLoadFloat3(&vertices[i1].normal);
+            XMVECTOR n2 = XMLoadFloat3(&vertices[i2].normal);
+
+            float d01 = XMVectorGetX(XMVector3Dot(n0, n1));
+            float d12 = XMVectorGetX(XMVector3Dot(n1, n2));
+
+            return d01 > 0.999f && d12 > 0.999f;
+        };
+
+    // ---- 三角形ごと ----
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        uint32_t i0 = indices[i + 0];
+        uint32_t i1 = indices[i + 1];
+        uint32_t i2 = indices[i + 2];
+
+        auto& v0 = vertices[i0];
+        auto& v1 = vertices[i1];
+        auto& v2 = vertices[i2];
+
+        XMVECTOR p0 = XMLoadFloat3(&v0.position);
+        XMVECTOR p1 = XMLoadFloat3(&v1.position);
+        XMVECTOR p2 = XMLoadFloat3(&v2.position);
+
+        float du1 = v1.texcoord.x - v0.texcoord.x;
+        float dv1 = v1.texcoord.y - v0.texcoord.y;
+        float du2 = v2.texcoord.x - v0.texcoord.x;
+        float dv2 = v2.texcoord.y - v0.texcoord.y;
+
+        float denom = du1 * dv2 - du2 * dv1;
+        if (fabs(denom) < 1e-6f)
+            continue;
+
+        float f = 1.0f / denom;
+
+        XMVECTOR e1 = p1 - p0;
+        XMVECTOR e2 = p2 - p0;
+
+        XMVECTOR T = (e1 * dv2 - e2 * dv1) * f;
+        XMVECTOR B = (e2 * du1 - e1 * du2) * f;
+
+        XMFLOAT3 t, b;
+        XMStoreFloat3(&t, T);
+        XMStoreFloat3(&b, B);
+
+        bool flat = isFlatFace(i0, i1, i2);
+
+        if (flat)
+        {
+            // フラット：上書き
+            set(i0, t, b);
+            set(i1, t, b);
+            set(i2, t, b);
+        }
+        else
+        {
+            // スムーズ：加算
+            add(i0, t, b);
+            add(i1, t, b);
+            add(i2, t, b);
+        }
+    }
+
+    // ---- 正規化 & handedness ----
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        XMVECTOR N = XMLoadFloat3(&vertices[i].normal);
+        XMVECTOR T = XMLoadFloat3(&tanAccum[i]);
+        XMVECTOR B = XMLoadFloat3(&bitanAccum[i]);
+
+        T = XMVector3Normalize(T - N * XMVector3Dot(N, T));
+
+        float w = (XMVectorGetX(
+            XMVector3Dot(XMVector3Cross(N, T), B)) < 0.0f)
+            ? -1.0f : 1.0f;
+
+        XMFLOAT3 t;
+        XMStoreFloat3(&t, T);
+        vertices[i].tangent = { t.x, t.y, t.z, w };
+    }
+}
+
+// mdlファイルの読み込み関数
+int ObjToImdl::ReadMdl(const char* fname, ModelData& model)
+{
+    // mdlファイルのオープン
+    std::ifstream ifs(fname, std::ios::binary);
+
+    if (!ifs)
+    {
+        // ファイルのオープン失敗
+        std::cout << "Could not open " << fname << std::endl;
+        return 1;
+    }
+
+    auto readCount = [&]() {
+        uint32_t cnt = 0;
+        ifs.read(reinterpret_cast<char*>(&cnt), sizeof(cnt));
+        return cnt;
+    };
+
+    auto readStrings = [&](std::vector<std::string>& strings) {
+        strings.resize(readCount());
+        for (auto& str : strings)
+        {
+            str.resize(readCount());
+            ifs.read(str.data(), str.size());
+        }
+    };
+
+    auto readArray = [&](auto& array) {
+        array.resize(readCount());
+        ifs.read(reinterpret_cast<char*>(array.data()), sizeof(array[0]) * array.size());
+    };
+
+    readStrings(model.textures);
+    readStrings(model.materialNames);
+    readArray(model.materials);
+    readArray(model.meshInfo);
+    readArray(model.indexBuffer);
+    readArray(model.vertexBuffer);
+
+    if (!ifs)
+    {
+        std::cout << "Invalid mdl file " << fname << std::endl;
+        return 1;
+    }
+
+    // 末尾の残りのデータ
+    model.extra.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+
+    // 圧縮したセクションは展開し、セクションやパックファイルに移したインデックス情報と頂点情報は取り出して
+    // 末尾のデータには残りのセクションを展開した状態で格納する
+    std::vector<char> extra;
+    extra.swap(model.extra);
+    std::vector<char> unwrapped;
+    size_t pos = 0;
+    while (pos < extra.size())
+    {
+        uint32_t header[2] = {};    // セクションID、セクションのサイズ
+        size_t rest = extra.size() - pos;
+        if (rest >= sizeof(header)) memcpy(header, extra.data() + pos, sizeof(header));
+        if (rest < sizeof(header) || header[1] > rest - sizeof(header))
+        {
+            // セクションとして解釈できない残りのデータはそのまま残す
+            model.extra.insert(model.extra.end(), extra.begin() + pos, extra.end());
+            break;
+        }
+
+        uint32_t id = header[0];
+        const char* data = extra.data() + pos + sizeof(header);
+        size_t size = header[1];
+        pos += sizeof(header) + size;
+
+        bool ok = true;
+        if (id == SectionId_Compressed)
+        {
+            ok = UnwrapSection(data, size, id, unwrapped);
+            data = unwrapped.data();
+            size = unwrapped.size();
+        }
+
+        if (ok && id == SectionId_IndexCodec)
+        {
+            ok = DecodeIndexBuffer(data, size, model.indexBuffer);
+        }
+        else if (ok && id == SectionId_VertexCodec)
+        {
+            ok = DecodeVertexBuffer(data, size, model.vertexBuffer);
+        }
+        else if (ok && id == SectionId_IndexBuffer)
+        {
+            model.indexBuffer.resize(size / sizeof(uint16_t));
+            memcpy(model.indexBuffer.data(), data, sizeof(uint16_t) * model.indexBuffer.size());
+        }
+        else if (ok && id == SectionId_VertexBuffer)
+        {
+            model.vertexBuffer.resize(size / sizeof(VertexPositionNormalTextureTangent));
+            memcpy(model.vertexBuffer.data(), data, sizeof(VertexPositionNormalTextureTangent) * model.vertexBuffer.size());
+        }
+        else if (ok && id == SectionId_PackReference)
+        {
+            ok = ReadPackReference(fname, data, size, model.indexBuffer, model.vertexBuffer);
+        }
+        else if (ok)
+        {
+            uint32_t sectionHeader[2] = { id, static_cast<uint32_t>(size) };
+            AppendData(model.extra, sectionHeader, sizeof(sectionHeader));
+            AppendData(model.extra, data, size);
+        }
+
+        if (!ok)
+        {
+            std::cout << "Invalid mdl file " << fname << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// 末尾のデータをセクションに分ける関数（セクションとして解釈できない残りのデータはID 0のセクションにする）
+static std::vector<std::pair<uint32_t, std::string_view>> SplitSections(const std::vector<char>& extra)
+{
+    std::vector<std::pair<uint32_t, std::string_view>> sections;
+    size_t pos = 0;
+    while (pos < extra.size())
+    {
+        uint32_t header[2] = {};    // セクションID、セクションのサイズ
+        size_t rest = extra.size() - pos;
+        if (rest >= sizeof(header)) memcpy(header, extra.data() + pos, sizeof(header));
+        if (rest < sizeof(header) || header[1] > rest - sizeof(header))
+        {
+            sections.emplace_back(0, std::string_view(extra.data() + pos, rest));
+            break;
+        }
+        sections.emplace_back(header[0], std::string_view(extra.data() + pos + sizeof(header), header[1]));
+        pos += sizeof(header) + header[1];
+    }
+    return sections;
+}
+
+// セクションIDを表示用の文字列にする関数
+static std::string SectionName(uint32_t id)
+{
+    if (id == 0) return "(unparsed data)";
+    std::string name = "'";
+    for (int i = 0; i < 4; i++) name += static_cast<char>((id >> (i * 8)) & 0xFF);
+    return name + "'";
+}
+
+// mdlファイルの比較関数
+int ObjToImdl::CompareMdl(const ModelData& a, const ModelData& b, float tolerance, bool ignoreAddedSections)
+{
+    auto nearlyEqual = [&](const float* fa, const float* fb, size_t cnt) {
+        for (size_t i = 0; i < cnt; i++)
+        {
+            if (!(fabs(fa[i] - fb[i]) <= tolerance)) return false;
+        }
+        return true;
+    };
+
+    auto error = [](const char* section, size_t index) {
+        std::cout << "Mismatch in " << section << " [" << index << "]" << std::endl;
+        return 1;
+    };
+
+    auto count = [](const char* section, size_t ca, size_t cb) {
+        std::cout << "Count mismatch in " << section << " (" << ca << " != " << cb << ")" << std::endl;
+        return 1;
+    };
+
+    // テクスチャ名、マテリアル名
+    if (a.textures.size() != b.textures.size()) return count("textures", a.textures.size(), b.textures.size());
+    for (size_t i = 0; i < a.textures.size(); i++)
+    {
+        if (a.textures[i] != b.textures[i]) return error("textures", i);
+    }
+    if (a.materialNames.size() != b.materialNames.size()) return count("material names", a.materialNames.size(), b.materialNames.size());
+    for (size_t i = 0; i < a.materialNames.size(); i++)
+    {
+        if (a.materialNames[i] != b.materialNames[i]) return error("material names", i);
+    }
+
+    // マテリアル（先頭の浮動小数点部分は許容誤差で比較）
+    if (a.materials.size() != b.materials.size()) return count("materials", a.materials.size(), b.materials.size());
+    for (size_t i = 0; i < a.materials.size(); i++)
+    {
+        const MaterialInfo& ma = a.materials[i];
+        const MaterialInfo& mb = b.materials[i];
+        constexpr size_t floatCnt = offsetof(MaterialInfo, textureIndex_BaseColor) / sizeof(float);
+        if (!nearlyEqual(&ma.diffuseColor.x, &mb.diffuseColor.x, floatCnt)
+            || ma.textureIndex_BaseColor != mb.textureIndex_BaseColor
+            || ma.textureIndex_NormalMap != mb.textureIndex_NormalMap) return error("materials", i);
+    }
+
+    // メッシュ情報、インデックス（完全一致）
+    if (a.meshInfo.size() != b.meshInfo.size()) return count("mesh info", a.meshInfo.size(), b.meshInfo.size());
+    if (!a.meshInfo.empty() && memcmp(a.meshInfo.data(), b.meshInfo.data(), sizeof(MeshInfo) * a.meshInfo.size()) != 0)
+    {
+        for (size_t i = 0; i < a.meshInfo.size(); i++)
+        {
+            if (memcmp(&a.meshInfo[i], &b.meshInfo[i], sizeof(MeshInfo)) != 0) return error("mesh info", i);
+        }
+    }
+    if (a.indexBuffer.size() != b.indexBuffer.size()) return count("indices", a.indexBuffer.size(), b.indexBuffer.size());
+    for (size_t i = 0; i < a.indexBuffer.size(); i++)
+    {
+        if (a.indexBuffer[i] != b.indexBuffer[i]) return error("indices", i);
+    }
+
+    // 頂点（許容誤差で比較）
+    if (a.vertexBuffer.size() != b.vertexBuffer.size()) return count("vertices", a.vertexBuffer.size(), b.vertexBuffer.size());
+    constexpr size_t vertexFloatCnt = sizeof(VertexPositionNormalTextureTangent) / sizeof(float);
+    for (size_t i = 0; i < a.vertexBuffer.size(); i++)
+    {
+        if (!nearlyEqual(&a.vertexBuffer[i].position.x, &b.vertexBuffer[i].position.x, vertexFloatCnt)) return error("vertices", i);
+    }
+
+    // 末尾のデータ（完全一致）
+    if (!ignoreAddedSections)
+    {
+        if (a.extra != b.extra) return error("trailing data", 0);
+        return 0;
+    }
+
+    // bにだけあるセクションは表示して読み飛ばし、共通のセクションは同じ順に完全一致で比較する
+    auto sectionsA = SplitSections(a.extra);
+    auto sectionsB = SplitSections(b.extra);
+    size_t next = 0;
+    for (size_t i = 0; i < sectionsA.size(); i++)
+    {
+        size_t j = next;
+        while (j < sectionsB.size() && sectionsB[j].first != sectionsA[i].first) j++;
+        if (j == sectionsB.size())
+        {
+            std::cout << "Missing section " << SectionName(sectionsA[i].first) << std::endl;
+            return 1;
+        }
+        if (sectionsA[i].second != sectionsB[j].second)
+        {
+            std::cout << "Mismatch in section " << SectionName(sectionsA[i].first) << std::endl;
+            return 1;
+        }
+        for (; next < j; next++) std::cout << "Added section " << SectionName(sectionsB[next].first) << " (ignored)" << std::endl;
+        next = j + 1;
+    }
+    for (; next < sectionsB.size(); next++) std::cout << "Added section " << SectionName(sectionsB[next].first) << " (ignored)" << std::endl;
+
+    return 0;
+}
+
+// objファイルをmdlファイルに変換する関数
+int ObjToImdl::Convert(const ConvertOptions& options, const InputSource& input, const OutputSink& output, ConvertResult* result)
+{
+    try
+    {
+        // チャンク形式はインデックス情報と頂点情報の全体を参照するデータとは併用できない
+        if (options.chunked && (options.meshlets || options.bvh || options.compressGeometry))
+        {
+            throw std::runtime_error("Chunked layout cannot be combined with meshlets, BVH or geometry compression");
+        }
+
+        // パックファイルにはそのままのインデックス情報と頂点情報を共有する
+        if (options.geometryPack && (options.chunked || options.compressGeometry))
+        {
+            throw std::runtime_error("Geometry pack cannot be combined with chunked layout or geometry compression");
+        }
+
+        // ノードはメッシュ情報の範囲で表すのでマテリアルをまとめる場合は使えない
+        if ((options.nodes || options.instancing) && options.mergeMaterials)
+        {
+            throw std::runtime_error("Nodes cannot be combined with merged materials");
+        }
+
+        // BVH、チャンク形式、オブジェクトごとの範囲は三角形リストを前提にしているのでストリップとは併用できない
+        if (options.strips && (options.bvh || options.chunked || options.objectRanges))
+        {
+            throw std::runtime_error("Strips cannot be combined with BVH, chunked layout or object ranges");
+        }
+
+        // ----- 情報取得 ----- //
+
+        // 解析結果のキャッシュ（ファイルから読み込む場合のみ）
+        std::string cachePath;
+        ObjCacheHeader cacheHeader = { ObjCacheMagic, ObjCacheVersion };
+        MappedFile cache;
+        bool cached = false;
+        cacheHeader.groups = (options.nodes || options.instancing) ? 1 : 0;
+        if (!options.cacheDirectory.empty() && input.data == nullptr
+            && GetSourceInfo(input.path, cacheHeader.sourceSize, cacheHeader.sourceTime))
+        {
+            cachePath = GetCachePath(options.cacheDirectory, input.path);
+            ObjCacheHeader header;
+            if (cache.Open(cachePath) && CheckObjCache(cache, cacheHeader, header))
+            {
+                cacheHeader = header;
+                cached = true;
+            }
+        }
+
+        // objファイルの内容（キャッシュを使用する場合は読み込まない）
+        std::string objText;
+        std::string_view objData(input.data, input.size);
+        if (input.data == nullptr && !cached)
+        {
+            if (ReadFileText(input.path, objText)) return 1;
+            objData = objText;
+        }
+
+        // 行数を数えて解析用のアリーナとバッファのサイズを決める
+        ObjCounts counts;
+        if (cached)
+        {
+            counts.positions = cacheHeader.positionCount;
+            counts.normals = cacheHeader.normalCount;
+            counts.texcoords = cacheHeader.texcoordCount;
+            counts.faces = cacheHeader.faceCount;
+        }
+        else
+        {
+            counts = PreScanObj(objData, cacheHeader.groups != 0);
+        }
+        size_t arenaSize = counts.positions * sizeof(XMFLOAT3)
+                         + counts.normals * sizeof(XMFLOAT3)
+                         + counts.texcoords * sizeof(XMFLOAT2)
+                         + counts.faces * sizeof(Face)
+                         + counts.faces * 3 * sizeof(FaceIndex);  // 頂点の結合用
+
+        // 解析中のデータはアリーナから確保して、変換終了時にまとめて解放する
+        CountingResource heap(std::pmr::new_delete_resource());
+        std::pmr::monotonic_buffer_resource arena(std::max<size_t>(arenaSize, 4096), &heap);
+        CountingResource requests(&arena);
+
+        Object object(&requests);
+
+        // キャッシュから解析結果を取得（壊れている場合はobjファイルを解析する）
+        if (cached && !LoadObjCache(cache, cacheHeader, object))
+        {
+            cached = false;
+            cache.Close();  // 作り直したキャッシュで置き換えられるように閉じる
+            object.mtllibs.clear();
+            object.positions.clear();
+            object.normals.clear();
+            object.texcoords.clear();
+            object.meshes.clear();
+            if (ReadFileText(input.path, objText)) return 1;
+            objData = objText;
+            counts = PreScanObj(objData, cacheHeader.groups != 0);
+        }
+
+        if (!cached)
+        {
+            // objファイルの情報取得（２回目の走査）
+            if (AnalyzeObj(objData, counts, cacheHeader.groups != 0, object)) return 1;
+
+            if (!cachePath.empty()) SaveObjCache(cachePath, object, cacheHeader);
+        }
+
+        if (result) result->fromCache = cached;
+
+        // 法線のない頂点の法線を生成
+        GenerateNormals(object, options.creaseAngle);
+
+        // mtlファイルの情報取得（同じ内容のmtlファイルは解析結果を共有する）
+        for (auto& mtllib : object.mtllibs)
+        {
+            mtllib = JoinPath(GetDirectoryPath(input.path), mtllib);
+        }
+
+        if (result) result->materialLibraries = object.mtllibs;
+
+        // マテリアルを取得（mtllibの順に連結する）
+        std::vector<MaterialInfo> materials;
+        std::vector<MaterialInfoEx> materialsEx;
+        std::unordered_map<std::string, uint32_t> materialIndexMap;
+        std::vector<std::string> textures;
+        std::unordered_map<std::string, int32_t> textureIndexMap;
+        std::unordered_map<std::string, std::string> texturePaths;  // テクスチャ名 → mtlファイルのディレクトリからのパス名
+        for (const auto& mtllib : object.mtllibs)
+        {
+            std::shared_ptr<const MaterialLibrary> library = LoadMaterialLibrary(mtllib, input.loadMaterial, options.cacheDirectory);
+            if (!library) return 1;
+            AppendMaterialLibrary(*library, materials, materialsEx, materialIndexMap, textures, textureIndexMap);
+
+            if (options.checkTextures)
+            {
+                for (size_t i = 0; i < library->textures.size(); i++)
+                {
+                    texturePaths.try_emplace(library->textures[i], JoinPath(GetDirectoryPath(mtllib), library->texturePaths[i]));
+                }
+            }
+        }
+
+        // マテリアル名の配列を作成
+        std::vector<std::string> materialNames(materials.size());
+        for (const auto& [name, index] : materialIndexMap)
+        {
+            materialNames[index] = name;
+        }
+
+        // ノード情報を取得（形状を共有するノードのサブメッシュは取り除く）
+        std::vector<NodeInfo> nodes;
+        std::vector<std::string> nodeNames;
+        if (options.nodes || options.instancing)
+        {
+            CreateNodes(object, options.instancing, nodes, nodeNames);
+        }
+
+        // 頂点、インデックスを取得
+        std::vector<MeshInfo> meshInfo;
+        std::vector<VertexPositionNormalTextureTangent> vertexBuffer;
+        std::vector<uint16_t> indexBuffer;
+        BoundingVolume modelBounds;
+        std::vector<BoundingVolume> meshBounds;
+        std::vector<ObjectRange> objectRanges;
+        CreateBufferData(object, materialIndexMap, options.mergeMaterials, meshInfo, vertexBuffer, indexBuffer, objectRanges, modelBounds, meshBounds);
+
+        // 頂点データに接線を追加
+        GenerateTangents(vertexBuffer, indexBuffer);
+
+        // マテリアルの整理
+        if (options.dedupMaterials || options.stripMaterials)
+        {
+            OptimizeMaterials(options.dedupMaterials, options.stripMaterials, materials, materialsEx, materialNames, textures, meshInfo);
+        }
+
+        // メッシュ情報を描画ステートの順に並べ替え
+        if (options.sortMeshes)
+        {
+            SortMeshes(materials, materialsEx, nodes, meshInfo, indexBuffer, meshBounds, objectRanges);
+        }
+
+        // テクスチャのファイルを確認（問題があれば出力しない）
+        if (options.checkTextures)
+        {
+            std::vector<std::string> problems;
+            CheckTextures(textures, texturePaths, problems);
+            if (result) result->missingTextures = problems;
+            if (!problems.empty()) return 1;
+        }
+
+        // ----- 拡張セクション ----- //
+
+        std::vector<Section> sections;
+
+        // 境界ボリューム
+        if (options.bounds)
+        {
+            Section bounds = { SectionId_Bounds };
+            AppendData(bounds.data, &modelBounds, sizeof(modelBounds));
+            AppendData(bounds.data, meshBounds.data(), sizeof(BoundingVolume) * meshBounds.size());
+            sections.push_back(std::move(bounds));
+        }
+
+        // 拡張マテリアル（使用するマテリアルがなければ出力しない）
+        if (options.extendedMaterials || std::any_of(materialsEx.begin(), materialsEx.end(), UsesExtendedMaterial))
+        {
+            Section materialEx = { SectionId_MaterialEx };
+            AppendData(materialEx.data, materialsEx.data(), sizeof(MaterialInfoEx) * materialsEx.size());
+            sections.push_back(std::move(materialEx));
+        }
+
+        // オブジェクトごとの範囲
+        if (options.objectRanges)
+        {
+            uint32_t rangeCount = static_cast<uint32_t>(objectRanges.size());
+            Section ranges = { SectionId_ObjectRanges };
+            AppendData(ranges.data, &rangeCount, sizeof(rangeCount));
+            AppendData(ranges.data, objectRanges.data(), sizeof(ObjectRange) * objectRanges.size());
+            sections.push_back(std::move(ranges));
+        }
+
+        // ノード
+        if (options.nodes || options.instancing)
+        {
+            uint32_t nodeCount = static_cast<uint32_t>(nodes.size());
+            Section node = { SectionId_Nodes };
+            AppendData(node.data, &nodeCount, sizeof(nodeCount));
+            AppendData(node.data, nodes.data(), sizeof(NodeInfo) * nodes.size());
+            for (const auto& name : nodeNames)
+            {
+                uint32_t len = static_cast<uint32_t>(name.size());
+                AppendData(node.data, &len, sizeof(len));
+                AppendData(node.data, name.data(), len);
+            }
+            sections.push_back(std::move(node));
+        }
+
+        // LOD
+        if (options.lodLevels > 0)
+        {
+            CreateLods(options, vertexBuffer, meshInfo, indexBuffer, sections);
+        }
+
+        // メッシュレット
+        if (options.meshlets)
+        {
+            CreateMeshlets(options, vertexBuffer, meshInfo, indexBuffer, sections);
+        }
+
+        // BVH
+        if (options.bvh)
+        {
+            CreateBvh(vertexBuffer, meshInfo, indexBuffer, sections);
+        }
+
+        // ストリップ
+        if (options.strips)
+        {
+            CreateStrips(meshInfo, indexBuffer, sections);
+        }
+
+        // チャンク形式
+        if (options.chunked)
+        {
+            CreateChunks(vertexBuffer, meshInfo, indexBuffer, sections);
+            indexBuffer.clear();
+            vertexBuffer.clear();
+        }
+
+        // インデックス情報と頂点情報の圧縮（他のセクションより先に展開できるように先頭に置く）
+        if (options.compressGeometry)
+        {
+            Section indices = { SectionId_IndexCodec };
+            EncodeIndexBuffer(indexBuffer.data(), indexBuffer.size(), indices.data);
+            Section vertices = { SectionId_VertexCodec };
+            EncodeVertexBuffer(vertexBuffer, vertices.data);
+
+            sections.insert(sections.begin(), std::move(vertices));
+            sections.insert(sections.begin(), std::move(indices));
+            indexBuffer.clear();
+            vertexBuffer.clear();
+        }
+
+        // インデックス情報と頂点情報をパックファイルに出力（同じ内容は他のモデルと共有する）
+        if (options.geometryPack)
+        {
+            PackBlob indices = options.geometryPack->Add(indexBuffer.data(), sizeof(uint16_t) * indexBuffer.size());
+            PackBlob vertices = options.geometryPack->Add(vertexBuffer.data(), sizeof(VertexPositionNormalTextureTangent) * vertexBuffer.size());
+
+            Section reference = { SectionId_PackReference };
+            WritePackReference(output.path, options.geometryPack->GetPath(), indices, vertices, reference.data);
+            sections.insert(sections.begin(), std::move(reference));
+            indexBuffer.clear();
+            vertexBuffer.clear();
+        }
+
+        // セクションの圧縮（インデックス情報と頂点情報もセクションに移して圧縮する）
+        if (options.sectionCodec != SectionCodec_None)
+        {
+            if (!options.compressGeometry && !options.chunked && !options.geometryPack)
+            {
+                Section indices = { SectionId_IndexBuffer };
+                AppendData(indices.data, indexBuffer.data(), sizeof(uint16_t) * indexBuffer.size());
+                Section vertices = { SectionId_VertexBuffer };
+                AppendData(vertices.data, vertexBuffer.data(), sizeof(VertexPositionNormalTextureTangent) * vertexBuffer.size());
+
+                sections.insert(sections.begin(), std::move(vertices));
+                sections.insert(sections.begin(), std::move(indices));
+                indexBuffer.clear();
+                vertexBuffer.clear();
+            }
+
+            CompressSections(options.sectionCodec, options.sectionRatio, sections);
+        }
+
+        if (result)
+        {
+            result->allocationRequests = requests.GetCount();
+            result->heapAllocations = heap.GetCount();
+            result->heapBytes = heap.GetBytes();
+        }
+
+        // ----- 書き出し ----- //
+
+        std::vector<char> localBuffer;
+        std::vector<char>& mdl = output.buffer ? *output.buffer : localBuffer;
+        mdl.clear();
+        OutputMdl(mdl, materials, meshInfo, materialNames, textures, vertexBuffer, indexBuffer, sections);
+
+        // メモリ上に出力する場合はここで終了
+        if (output.buffer) return 0;
+
+        // mdlファイルのオープン
+        std::ofstream ofs(output.path, std::ios::binary);
+
+        if (!ofs.is_open())
+        {
+            // ファイルのオープン失敗
+            std::cout << "Could not open " << output.path << std::endl;
+            return 1;
+        }
+
+        ofs.write(mdl.data(), mdl.size());
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
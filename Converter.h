@@ -0,0 +1,96 @@
+﻿// Converter.h : wavefront形式のファイルを独自形式のモデルデータに変換するライブラリ
+// コマンドラインツール以外（エディタ、ビルドサーバー等）からも直接呼び出して使用する
+
+#pragma once
+
+#include "ObjToMdl.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ObjToImdl
+{
+    class GeometryPack;
+
+    // mtlファイルの取得関数（ファイル名から内容を取得、失敗時はfalse）
+    using MaterialLoader = std::function<bool(const std::string& fname, std::string& text)>;
+
+    // 変換オプション
+    struct ConvertOptions
+    {
+        uint32_t lodLevels = 0;     // 作成するLODのレベル数（0の場合は作成しない）
+        float lodRatio = 0.5f;      // LODのレベルごとの三角形数の比率
+        bool bounds = false;                    // モデル全体とメッシュ情報ごとの境界ボリュームを出力する
+        bool meshlets = false;                  // メッシュレットを作成する
+        uint32_t meshletMaxVertices = 64;       // メッシュレットの最大頂点数（256まで）
+        uint32_t meshletMaxTriangles = 124;     // メッシュレットの最大三角形数
+        bool bvh = false;                       // レイキャスト用のBVHを作成する
+        bool compressGeometry = false;          // インデックス情報と頂点情報を圧縮して出力する
+        uint32_t sectionCodec = SectionCodec_None;  // セクションの圧縮形式
+        float sectionRatio = 0.9f;              // 圧縮後のサイズがこの比率以下になるセクションのみ圧縮する
+        bool chunked = false;                   // メッシュ情報とLODのレベルごとのチャンクに分けて出力する
+        bool strips = false;                    // 小さくなるメッシュ情報はストリップに変換する
+        std::string cacheDirectory;             // obj、mtlファイルの解析結果のキャッシュの保存先（空の場合は使用しない）
+        bool mergeMaterials = false;            // 同じマテリアルのサブメッシュを１つのメッシュ情報にまとめる
+        bool objectRanges = false;              // メッシュ情報の中のオブジェクトごとの範囲を出力する
+        bool nodes = false;                     // objファイルのo、gをノードとして出力する
+        bool instancing = false;                // 形状が同じノードのメッシュ情報を共有する（ノードも出力する）
+        bool extendedMaterials = false;         // 拡張マテリアルを常に出力する（falseの場合は使用するマテリアルがある場合のみ）
+        bool dedupMaterials = false;            // 内容が同じマテリアルを１つにまとめる
+        bool stripMaterials = false;            // 使用していないマテリアル、マテリアル名、テクスチャを出力しない
+        bool sortMeshes = false;                // メッシュ情報を描画ステート（透明、法線マップ、テクスチャ、マテリアル）の順に並べる
+        bool checkTextures = false;             // テクスチャのファイルがmtlファイルからの相対パスにあるか確認する（ない場合は出力しない）
+        float creaseAngle = 180.0f;             // 法線を生成する場合に平均する面の法線の最大の角度（度）
+        GeometryPack* geometryPack = nullptr;   // インデックス情報と頂点情報の出力先のパックファイル（nullptrの場合はmdlファイルに出力する）
+    };
+
+    // 入力元
+    struct InputSource
+    {
+        std::string path;               // objファイル名（mtlファイルはこのファイルのディレクトリから検索）
+        const char* data = nullptr;     // メモリ上のobjデータ（nullptrの場合はpathから読み込む）
+        size_t size = 0;                // メモリ上のobjデータのサイズ
+        MaterialLoader loadMaterial;    // mtlファイルの取得（未指定の場合はファイルから読み込む）
+    };
+
+    // 出力先
+    struct OutputSink
+    {
+        std::string path;                       // 出力ファイル名
+        std::vector<char>* buffer = nullptr;    // メモリ上の出力先（nullptrでない場合はファイルに出力しない）
+    };
+
+    // 変換結果
+    struct ConvertResult
+    {
+        std::vector<std::string> materialLibraries; // 参照したmtlファイル名
+        size_t allocationRequests = 0;              // 解析中のメモリ確保要求の回数（アリーナがない場合のヒープ確保回数）
+        size_t heapAllocations = 0;                 // 解析中にアリーナがヒープから確保した回数
+        size_t heapBytes = 0;                       // 解析中にアリーナがヒープから確保したサイズ
+        bool fromCache = false;                     // objファイルの解析結果のキャッシュを使用した
+        std::vector<std::string> missingTextures;   // 見つからないか壊れているテクスチャのパス名（checkTexturesの場合）
+    };
+
+    // mdlファイルの内容
+    struct ModelData
+    {
+        std::vector<std::string> textures;                              // テクスチャ名
+        std::vector<std::string> materialNames;                         // マテリアル名
+        std::vector<MaterialInfo> materials;                            // マテリアル
+        std::vector<MeshInfo> meshInfo;                                 // メッシュ情報
+        std::vector<uint16_t> indexBuffer;                              // インデックス
+        std::vector<VertexPositionNormalTextureTangent> vertexBuffer;   // 頂点
+        std::vector<char> extra;                                        // 末尾の未解釈データ
+    };
+
+    // objファイルをmdlファイルに変換する関数（成功時は0）
+    int Convert(const ConvertOptions& options, const InputSource& input, const OutputSink& output, ConvertResult* result = nullptr);
+
+    // mdlファイルの読み込み関数（圧縮したセクション、インデックス情報と頂点情報は展開し、パックファイルの参照は読み込む、成功時は0）
+    int ReadMdl(const char* fname, ModelData& model);
+
+    // mdlファイルの比較関数（浮動小数点は許容誤差内なら一致とみなす、一致時は0）
+    // ignoreAddedSectionsがtrueの場合はbにだけある拡張セクションを表示して比較しない
+    int CompareMdl(const ModelData& a, const ModelData& b, float tolerance, bool ignoreAddedSections = false);
+}
@@ -0,0 +1,174 @@
+﻿// ImageHeader.cpp : テクスチャの画像ファイルのヘッダーから形式と大きさを取得する
+//
+// 画像全体は読み込まず、大きさが書かれている位置までを読む
+// tgaファイルには識別子がないので拡張子で判定する
+
+#include "ImageHeader.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace ObjToImdl;
+
+// ビッグエンディアンの値を取得する関数
+static uint32_t ReadBigEndian(const unsigned char* p, int bytes)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < bytes; i++) value = (value << 8) | p[i];
+    return value;
+}
+
+// リトルエンディアンの値を取得する関数
+static uint32_t ReadLittleEndian(const unsigned char* p, int bytes)
+{
+    uint32_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) value = (value << 8) | p[i];
+    return value;
+}
+
+// jpegファイルの大きさを取得する関数（SOFマーカーまでセグメントを読み飛ばす）
+static void ReadJpegSize(std::ifstream& ifs, ImageHeader& header)
+{
+    ifs.seekg(2);
+    for (;;)
+    {
+        // マーカー（前に0xFFが続く場合がある）
+        int c = ifs.get();
+        if (c != 0xFF) return;
+        while (c == 0xFF) c = ifs.get();
+        if (c == EOF) return;
+
+        // 長さを持たないマーカー
+        if (c == 0x01 || (c >= 0xD0 && c <= 0xD7)) continue;
+        if (c == 0xD9 || c == 0xDA) return;     // 画像の終わり、画像データの始まり
+
+        unsigned char segment[7];
+        if (!ifs.read(reinterpret_cast<char*>(segment), 2)) return;
+        uint32_t length = ReadBigEndian(segment, 2);
+        if (length < 2) return;
+
+        // SOF0～SOF15（DHT、JPG、DACを除く）
+        if (c >= 0xC0 && c <= 0xCF && c != 0xC4 && c != 0xC8 && c != 0xCC)
+        {
+            if (length < 7 || !ifs.read(reinterpret_cast<char*>(segment + 2), 5)) return;
+            header.height = ReadBigEndian(segment + 3, 2);
+            header.width = ReadBigEndian(segment + 5, 2);
+            return;
+        }
+
+        ifs.seekg(length - 2, std::ios::cur);
+    }
+}
+
+// hdrファイルの大きさを取得する関数（空行の次の行に"-Y 高さ +X 幅"の形で書かれている）
+static void ReadHdrSize(std::ifstream& ifs, ImageHeader& header)
+{
+    ifs.seekg(0);
+    std::string line;
+    for (int i = 0; i < 64 && std::getline(ifs, line); i++)
+    {
+        if (!line.empty()) continue;
+        if (!std::getline(ifs, line)) return;
+
+        std::istringstream iss(line);
+        std::string axisY, axisX;
+        uint32_t height = 0, width = 0;
+        if (!(iss >> axisY >> height >> axisX >> width)) return;
+        if (axisY.size() != 2 || axisX.size() != 2) return;
+
+        // 縦横が入れ替わっている場合
+        if (axisY[1] == 'X') std::swap(height, width);
+        header.width = width;
+        header.height = height;
+        return;
+    }
+}
+
+// 画像ファイルのヘッダーのみを読み込む関数（ファイルを開けない場合はfalse）
+bool ObjToImdl::ReadImageHeader(const std::string& path, ImageHeader& header)
+{
+    header = {};
+
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) return false;
+
+    unsigned char data[32] = {};
+    ifs.read(reinterpret_cast<char*>(data), sizeof(data));
+    size_t size = static_cast<size_t>(ifs.gcount());
+    ifs.clear();
+
+    // png（IHDRチャンクに大きさがある）
+    if (size >= 8 && memcmp(data, "\x89PNG\r\n\x1A\n", 8) == 0)
+    {
+        header.format = "png";
+        if (size >= 24 && memcmp(data + 12, "IHDR", 4) == 0)
+        {
+            header.width = ReadBigEndian(data + 16, 4);
+            header.height = ReadBigEndian(data + 20, 4);
+        }
+    }
+
+    // jpeg
+    else if (size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF)
+    {
+        header.format = "jpeg";
+        ReadJpegSize(ifs, header);
+    }
+
+    // bmp（高さが負の場合は上から下の順）
+    else if (size >= 26 && data[0] == 'B' && data[1] == 'M')
+    {
+        header.format = "bmp";
+        if (ReadLittleEndian(data + 14, 4) == 12)
+        {
+            header.width = ReadLittleEndian(data + 18, 2);
+            header.height = ReadLittleEndian(data + 20, 2);
+        }
+        else
+        {
+            header.width = ReadLittleEndian(data + 18, 4);
+            header.height = static_cast<uint32_t>(std::abs(static_cast<int32_t>(ReadLittleEndian(data + 22, 4))));
+        }
+    }
+
+    // dds
+    else if (size >= 20 && memcmp(data, "DDS ", 4) == 0)
+    {
+        header.format = "dds";
+        if (ReadLittleEndian(data + 4, 4) == 124)
+        {
+            header.height = ReadLittleEndian(data + 12, 4);
+            header.width = ReadLittleEndian(data + 16, 4);
+        }
+    }
+
+    // hdr
+    else if (size >= 2 && data[0] == '#' && data[1] == '?')
+    {
+        header.format = "hdr";
+        ReadHdrSize(ifs, header);
+    }
+
+    // tga（画像の種類が対応しているものの場合のみ大きさを使う）
+    else
+    {
+        std::string extension = std::filesystem::path(path).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (extension == ".tga")
+        {
+            header.format = "tga";
+            uint8_t type = data[2];
+            if (size >= 18 && (type == 1 || type == 2 || type == 3 || type == 9 || type == 10 || type == 11))
+            {
+                header.width = ReadLittleEndian(data + 12, 2);
+                header.height = ReadLittleEndian(data + 14, 2);
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,20 @@
+﻿// ImageHeader.h : テクスチャの画像ファイルのヘッダーから形式と大きさを取得する
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace ObjToImdl
+{
+    // 画像ファイルのヘッダーの情報
+    struct ImageHeader
+    {
+        const char* format = nullptr;   // 形式（"png"、"jpeg"、"bmp"、"tga"、"dds"、"hdr"、対応していない形式の場合はnullptr）
+        uint32_t width = 0;             // 幅（ヘッダーが壊れている場合は0）
+        uint32_t height = 0;            // 高さ（ヘッダーが壊れている場合は0）
+    };
+
+    // 画像ファイルのヘッダーのみを読み込む関数（ファイルを開けない場合はfalse）
+    bool ReadImageHeader(const std::string& path, ImageHeader& header);
+}
@@ -0,0 +1,233 @@
+﻿// Meshlet.cpp : GPUでのクラスタ単位のカリング用にメッシュをメッシュレットに分割する
+
+#include "Meshlet.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+using namespace DirectX;
+using namespace ObjToImdl;
+
+// ３点から法線（正規化なし）を求める関数（頂点の法線と同じ向き）
+static XMVECTOR FaceNormal(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2)
+{
+    XMVECTOR v0 = XMLoadFloat3(&p0);
+    return XMVector3Cross(XMLoadFloat3(&p2) - v0, XMLoadFloat3(&p1) - v0);
+}
+
+// メッシュレットの境界球と法線コーンを求める関数
+static void ComputeBounds(const std::vector<VertexPositionNormalTextureTangent>& vertices,
+                          const uint16_t* meshletVertices, const uint8_t* meshletTriangles,
+                          Meshlet& meshlet)
+{
+    auto position = [&](uint32_t local) -> const XMFLOAT3& {
+        return vertices[meshletVertices[local]].position;
+    };
+
+    // ---- 境界球（Ritterの方法） ----
+    // 任意の点から最も遠い点 a、a から最も遠い点 b を求めて ab を直径とする球から始める
+    XMVECTOR p0 = XMLoadFloat3(&position(0));
+    uint32_t a = 0;
+    float maxDist = -1.0f;
+    for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+    {
+        float d = XMVectorGetX(XMVector3LengthSq(XMLoadFloat3(&position(i)) - p0));
+        if (d > maxDist) { maxDist = d; a = i; }
+    }
+    XMVECTOR pa = XMLoadFloat3(&position(a));
+    uint32_t b = a;
+    maxDist = -1.0f;
+    for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+    {
+        float d = XMVectorGetX(XMVector3LengthSq(XMLoadFloat3(&position(i)) - pa));
+        if (d > maxDist) { maxDist = d; b = i; }
+    }
+
+    XMVECTOR center = (pa + XMLoadFloat3(&position(b))) * 0.5f;
+    float radius = std::sqrt(maxDist) * 0.5f;
+
+    // 球の外にある点を含むように広げる
+    for (uint32_t i = 0; i < meshlet.vertexCount; i++)
+    {
+        XMVECTOR p = XMLoadFloat3(&position(i));
+        float d = XMVectorGetX(XMVector3Length(p - center));
+        if (d > radius)
+        {
+            float newRadius = (radius + d) * 0.5f;
+            center = center + (p - center) * ((newRadius - radius) / d);
+            radius = newRadius;
+        }
+    }
+
+    XMStoreFloat3(&meshlet.center, center);
+    meshlet.radius = radius;
+
+    // ---- 法線コーン ----
+    // 軸は面の法線の平均、開き角は軸と最も離れた面の法線で決める
+    std::vector<std::pair<XMVECTOR, XMVECTOR>> faces;  // 面の法線と面上の点
+    faces.reserve(meshlet.triangleCount);
+    XMVECTOR axis = XMVectorZero();
+    for (uint32_t i = 0; i < meshlet.triangleCount; i++)
+    {
+        const uint8_t* t = &meshletTriangles[i * 3];
+        XMVECTOR n = FaceNormal(position(t[0]), position(t[1]), position(t[2]));
+        if (XMVectorGetX(XMVector3LengthSq(n)) <= 0.0f) continue;    // 縮退した三角形は無視
+        n = XMVector3Normalize(n);
+        faces.emplace_back(n, XMLoadFloat3(&position(t[0])));
+        axis += n;
+    }
+
+    // コーンを使えない場合はカリングされない値にする
+    meshlet.coneApex = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    meshlet.coneAxis = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    meshlet.coneCutoff = 1.0f;
+
+    if (faces.empty() || XMVectorGetX(XMVector3LengthSq(axis)) <= 0.0f) return;
+    axis = XMVector3Normalize(axis);
+
+    float minDot = 1.0f;
+    for (const auto& face : faces)
+    {
+        minDot = std::min(minDot, XMVectorGetX(XMVector3Dot(face.first, axis)));
+    }
+
+    // 開き角が90度に近い（またはそれ以上の）場合は裏向き判定に使えない
+    if (minDot <= 0.1f) return;
+
+    // コーンの頂点はすべての面の平面の裏側になる位置まで軸に沿って下げる
+    float maxT = 0.0f;
+    for (const auto& face : faces)
+    {
+        float dc = XMVectorGetX(XMVector3Dot(center - face.second, face.first));
+        float dn = XMVectorGetX(XMVector3Dot(axis, face.first));
+        maxT = std::max(maxT, dc / dn);
+    }
+
+    XMStoreFloat3(&meshlet.coneApex, center - axis * maxT);
+    XMStoreFloat3(&meshlet.coneAxis, axis);
+    meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+// 三角形リストをメッシュレットに分割する関数
+void ObjToImdl::BuildMeshlets(const std::vector<VertexPositionNormalTextureTangent>& vertices,
+                              const uint16_t* indices, size_t indexCount,
+                              uint32_t maxVertices, uint32_t maxTriangles,
+                              std::vector<Meshlet>& meshlets,
+                              std::vector<uint16_t>& meshletVertices,
+                              std::vector<uint8_t>& meshletTriangles)
+{
+    // ローカルインデックスは8ビットなので頂点数は256まで
+    maxVertices = std::min(std::max(maxVertices, 3u), 256u);
+    maxTriangles = std::max(maxTriangles, 1u);
+
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) return;
+
+    // ---- 頂点を共有する三角形の一覧（頂点ごとに連続して格納） ----
+    std::vector<uint32_t> adjacencyStart(vertices.size() + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++) adjacencyStart[indices[i] + 1]++;
+    for (size_t i = 0; i < vertices.size(); i++) adjacencyStart[i + 1] += adjacencyStart[i];
+
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    std::vector<uint32_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+    {
+        adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<bool> used(triangleCount, false);
+    std::vector<int> localIndex(vertices.size(), -1);   // 作成中のメッシュレット内での番号
+    std::vector<uint16_t> current;                      // 作成中のメッシュレットの頂点
+    size_t next = 0;                                    // 未使用の三角形を探す開始位置
+    Meshlet meshlet = {};
+
+    // 作成中のメッシュレットを確定する
+    auto flush = [&]() {
+        meshlet.vertexCount = static_cast<uint32_t>(current.size());
+        ComputeBounds(vertices, &meshletVertices[meshlet.vertexOffset],
+                      &meshletTriangles[meshlet.triangleOffset * 3], meshlet);
+        meshlets.push_back(meshlet);
+
+        for (auto v : current) localIndex[v] = -1;
+        current.clear();
+    };
+
+    // 三角形を追加した場合に増える頂点数
+    auto newVertexCount = [&](size_t tri) {
+        int count = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            if (localIndex[indices[tri * 3 + k]] < 0) count++;
+        }
+        return count;
+    };
+
+    // 三角形を作成中のメッシュレットに追加する
+    auto addTriangle = [&](size_t tri) {
+        for (int k = 0; k < 3; k++)
+        {
+            uint16_t v = indices[tri * 3 + k];
+            if (localIndex[v] < 0)
+            {
+                localIndex[v] = static_cast<int>(current.size());
+                current.push_back(v);
+                meshletVertices.push_back(v);
+            }
+            meshletTriangles.push_back(static_cast<uint8_t>(localIndex[v]));
+        }
+        meshlet.triangleCount++;
+        used[tri] = true;
+    };
+
+    for (;;)
+    {
+        // 作成中のメッシュレットの頂点に隣接する三角形から、共有する頂点が最も多いものを選ぶ
+        size_t best = triangleCount;
+        int bestNew = 4;
+        if (!current.empty() && meshlet.triangleCount < maxTriangles)
+        {
+            for (auto v : current)
+            {
+                for (uint32_t i = adjacencyStart[v]; i < adjacencyStart[v + 1]; i++)
+                {
+                    uint32_t tri = adjacency[i];
+                    if (used[tri]) continue;
+
+                    int count = newVertexCount(tri);
+                    if (current.size() + count > maxVertices) continue;
+                    if (count < bestNew || (count == bestNew && tri < best))
+                    {
+                        best = tri;
+                        bestNew = count;
+                    }
+                }
+            }
+        }
+
+        if (best == triangleCount)
+        {
+            // 隣接する三角形がなければ未使用の三角形を順に使う
+            while (next < triangleCount && used[next]) next++;
+            if (next == triangleCount) break;
+            best = next;
+
+            // 入りきらない場合は新しいメッシュレットを始める
+            if (!current.empty() &&
+                (meshlet.triangleCount >= maxTriangles || current.size() + newVertexCount(best) > maxVertices))
+            {
+                flush();
+            }
+        }
+
+        if (current.empty())
+        {
+            meshlet = {};
+            meshlet.vertexOffset = static_cast<uint32_t>(meshletVertices.size());
+            meshlet.triangleOffset = static_cast<uint32_t>(meshletTriangles.size() / 3);
+        }
+
+        addTriangle(best);
+    }
+
+    if (!current.empty()) flush();
+}
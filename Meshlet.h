@@ -0,0 +1,19 @@
+﻿// Meshlet.h : GPUでのクラスタ単位のカリング用にメッシュをメッシュレットに分割する
+
+#pragma once
+
+#include "ObjToMdl.h"
+#include <cstdint>
+#include <vector>
+
+namespace ObjToImdl
+{
+    // 三角形リストをメッシュレットに分割する関数（結果は各配列の末尾に追加する）
+    // meshletVerticesには頂点情報のインデックス、meshletTrianglesにはメッシュレット内のローカルインデックスを格納する
+    void BuildMeshlets(const std::vector<VertexPositionNormalTextureTangent>& vertices,
+                       const uint16_t* indices, size_t indexCount,
+                       uint32_t maxVertices, uint32_t maxTriangles,
+                       std::vector<Meshlet>& meshlets,
+                       std::vector<uint16_t>& meshletVertices,
+                       std::vector<uint8_t>& meshletTriangles);
+}
@@ -1,125 +1,25 @@
 ﻿// ObjToIma.cpp : このファイルには 'main' 関数が含まれています。プログラム実行の開始と終了がそこで行われます。
 // wavefront形式のファイルを独自形式のモデルデータに変換するツール
-
-// ------------------------------------------------------------ //
-// モデルデータフォーマット
-//
-// テクスチャ名の数(uint32_t)
-//      |テクスチャ名の文字数(uint32_t)   |*cnt
-//      |テクスチャ名(char)               |
-//
-// マテリアル名の数(uint32_t)
-//      |マテリアル名の文字数(uint32_t)   |*cnt
-//      |マテリアル名(char)               |
-//
-// マテリアルの数(uint32_t)
-//      マテリアル(MaterialInfo*cnt)
-//
-// メッシュ情報の数(uint32_t)
-//      メッシュ情報(MeshInfo*cnt)
-//
-// インデックス情報の数(uint32_t)
-//      インデックス情報(uint16_t * cnt)
-//
-// 頂点情報の数(uint32_t)
-//      頂点情報(VertexPositionNormalTextureTangent * cnt)
-//
-// ------------------------------------------------------------ //
-
-#include "ObjToMdl.h"
+// 変換処理はConverter.cppにあり、ここでは引数の解析のみを行う
+
+#include "Converter.h"
+#include "Codec.h"
+#include "Pack.h"
+#include "Server.h"
+#include "Watcher.h"
+#include <algorithm>
 #include <iostream>
 #include <windows.h>
 #include <vector>
-#include <fstream>
 #include <string>
-#include <unordered_map>
+#include <thread>
+#include <chrono>
+#include <iomanip>
+#include <cstring>
 #include "cxxopts.hpp"
 
-using namespace DirectX;
 using namespace ObjToImdl;
 
-// 面の各頂点を構成するインデックス
-struct FaceIndex
-{
-    int v;  // 位置
-    int vt; // テクスチャ座標
-    int vn; // 法線
-
-    bool operator==(const FaceIndex& other) const
-    {
-        return v == other.v && vt == other.vt && vn == other.vn;
-    }
-};
-
-// ハッシュ値を生成する関数
-namespace std
-{
-    template <>
-    struct hash<FaceIndex>
-    {
-        size_t operator()(const FaceIndex& f) const
-        {
-            size_t h1 = std::hash<int>()(f.v);
-            size_t h2 = std::hash<int>()(f.vt);
-            size_t h3 = std::hash<int>()(f.vn);
-
-            // ハッシュ合成
-            return h1 ^ (h2 << 1) ^ (h3 << 2);
-        }
-    };
-}
-
-// 面（三角形）
-struct Face
-{
-    FaceIndex faceIndices[3];
-};
-
-// サブメッシュ
-struct SubMesh
-{
-    std::string material;       // マテリアル名
-    std::vector<Face> faces;    // 面（三角形）情報
-};
-
-// メッシュ
-struct Mesh
-{
-    std::vector<SubMesh> subMeshs;  // サブメッシュ
-};
-
-// obj形式の情報取得用構造体
-struct Object
-{
-    std::string mtllib;                         // マテリアルファイル名
-    std::vector<DirectX::XMFLOAT3> positions;   // 位置
-    std::vector<DirectX::XMFLOAT3> normals;     // 法線
-    std::vector<DirectX::XMFLOAT2> texcoords;   // テクスチャ座標
-    std::vector<Mesh> meshes;                   // メッシュ
-};
-
-// パス名付きファイル名のファイル名を取得する関数
-static std::string GetFileNameOnly(const std::string& path)
-{
-    return std::filesystem::path(path).filename().string();
-}
-
-// ファイルから読み込む関数（XMFLOAT2）
-static XMFLOAT2 ReadFloat2(std::istringstream& iss)
-{
-    XMFLOAT2 val = {};
-    iss >> val.x >> val.y;
-    return val;
-}
-
-// ファイルから読み込む関数（XMFLOAT3）
-static XMFLOAT3 ReadFloat3(std::istringstream& iss)
-{
-    XMFLOAT3 val = {};
-    iss >> val.x >> val.y >> val.z;
-    return val;
-}
-
 // UTF-16 → UTF-8 変換
 static std::string WStringToUtf8(const std::wstring& ws)
 {
@@ -145,592 +45,370 @@ static void Help()
 {
     std::cout <<
         "Usage:\n"
-        "  ObjToMdl <input.obj> [-o output.mdl]\n\n"
+        "  ObjToMdl <input.obj>... [-o output.mdl]\n"
+        "  ObjToMdl --server [--pipe name] [--threads n] [--max-request MiB]\n"
+        "  ObjToMdl --watch <dir>...\n\n"
         "Options:\n"
-        "  -o, --output <file>   Output file\n"
+        "  -o, --output <file>   Output file (single input only)\n"
+        "  -c, --compare <path>  Compare output with reference .mdl (file or directory)\n"
+        "  -t, --tolerance <val> Float tolerance for --compare (default 0 = exact)\n"
+        "      --ignore-added-sections  Let --compare skip sections the reference does not have\n"
+        "      --server          Run as conversion server on a named pipe\n"
+        "      --pipe <name>     Pipe name for --server (default ObjToMdl)\n"
+        "      --threads <n>     Worker threads for --server (default CPU count)\n"
+        "      --max-request <MiB>  Largest OBJ data --server accepts (default 256)\n"
+        "  -w, --watch <dir>     Reconvert changed .obj/.mtl files in directory\n"
+        "      --stats           Print parse-time allocation counts\n"
+        "      --lod <n>         Generate n simplified LOD levels per mesh\n"
+        "      --lod-ratio <r>   Triangle ratio between LOD levels (default 0.5)\n"
+        "      --bounds          Write model and per-mesh bounding volumes\n"
+        "      --meshlets        Generate meshlets with bounds and normal cones\n"
+        "      --meshlet-vertices <n>  Max vertices per meshlet (default 64, max 256)\n"
+        "      --meshlet-triangles <n> Max triangles per meshlet (default 124)\n"
+        "      --bvh             Generate an SAH BVH for raycasts\n"
+        "      --compress        Compress index and vertex buffers\n"
+        "      --benchmark       Print compression ratio and decode speed\n"
+        "      --section-codec <c>  Compress sections (xpress, xpress-huff, lzms)\n"
+        "      --section-ratio <r>  Keep a compressed section only if size <= r * raw (default 0.9)\n"
+        "      --chunked         Split geometry into streamable chunks per mesh and LOD\n"
+        "      --strips          Use triangle strips with restart index where smaller\n"
+        "      --cache-dir <dir> Cache parsed .obj data to skip parsing on later runs\n"
+        "      --merge-materials Merge submeshes sharing a material into one mesh\n"
+        "      --object-ranges   Write per-object ranges within each mesh\n"
+        "      --nodes           Write o/g names as scene nodes\n"
+        "      --instancing      Store identical nodes once as instances (implies --nodes)\n"
+        "      --extended-materials Always write extended material parameters\n"
+        "      --dedup-materials Merge materials with identical parameters\n"
+        "      --strip-materials Drop materials, names and textures no mesh uses\n"
+        "      --sort-meshes     Order draw ranges by render state to minimize state changes\n"
+        "      --check-textures  Fail if a texture is missing or has a broken image header\n"
+        "      --crease-angle <deg> Max angle between smoothed faces when generating normals (default 180)\n"
+        "      --pack <file>     Store geometry of all inputs in a shared, deduplicated pack file\n"
         "  -h, --help            Show help\n";
 }
 
-// 引数から入力ファイル名と出力ファイル名を取得する関数
-static int AnalyzeOption(int argc, char* argv[], std::string& input, std::string& output)
+// コマンドライン引数
+struct CommandOptions
 {
-    // cxxoptsで引数解析
-    cxxopts::Options options("ObjToMdl");
-    options.add_options()
-        ("input", "Input model file (.obj)",
-            cxxopts::value<std::string>())
-        ("o,output", "Output file",
-            cxxopts::value<std::string>())
-        ("h,help", "Show help");
-    options.parse_positional({ "input" });
-
-    try
-    {
-        auto result = options.parse(argc, argv);
-
-        // -h,--help 指定された
-        if (result.count("help"))
-        {
-            Help();
-            return 0;
-        }
-
-        // 入力ファイル名
-        input = result["input"].as<std::string>();
-
-        // -o,-output 出力ファイル名
-        if (result.count("output") == 0) {
-            // 指定されていない場合は出力ファイル名は、入力ファイル名.mdlにする
-            std::filesystem::path p(input);
-            p.replace_extension(".mdl");
-            output = p.string();
-        }
-        else
-        {
-            // 指定された
-            output = result["output"].as<std::string>();
-        }
-    }
-    catch (const std::exception& e)
-    {
-        std::cerr << "Error: " << e.what() << std::endl;
-        Help();
-        return 1;
-    }
-
-    return 0;
-}
+    std::vector<std::string> inputs;    // 入力ファイル名
+    std::string output;                 // 出力ファイル名（入力ファイルが１つの場合のみ）
+    std::string compare;                // 比較する正解データ（ファイルまたはディレクトリ）
+    float tolerance = 0.0f;             // 比較時の浮動小数点の許容誤差
+    bool ignoreAddedSections = false;   // 比較時に正解データにない拡張セクションを無視する
+    bool server = false;                // 常駐サーバーとして起動
+    std::string pipeName = DefaultPipeName; // サーバーのパイプ名
+    unsigned int threads = std::thread::hardware_concurrency(); // サーバーのワーカースレッド数
+    uint32_t maxRequestMiB = DefaultMaxRequestMiB;  // サーバーが受け付けるobjデータの最大サイズ（MiB）
+    std::vector<std::string> watch;     // 監視するディレクトリ
+    bool stats = false;                 // 解析中のメモリ確保回数を表示
+    bool benchmark = false;             // 圧縮率と展開速度を表示
+    std::string pack;                   // インデックス情報と頂点情報を共有するパックファイル名
+    ConvertOptions convert;             // 変換オプション
+};
 
-// 面の各頂点を構成するインデックス取得関数
-static std::vector<FaceIndex> ParseFaceLine(const std::string& line, Object& object)
+// 変換オプションを取得する関数
+static void AnalyzeConvertOption(const cxxopts::ParseResult& result, ConvertOptions& convert)
 {
-    auto fixIndex = [&](int raw, int size) {
-        if (raw > 0)  return raw - 1;
-        if (raw < 0)  return size + raw;
-        throw std::runtime_error("OBJ index cannot be zero");
-    };
+    // --lod LODのレベル数
+    if (result.count("lod")) convert.lodLevels = result["lod"].as<uint32_t>();
 
-    std::istringstream iss(line);
+    // --lod-ratio LODのレベルごとの三角形数の比率
+    if (result.count("lod-ratio")) convert.lodRatio = result["lod-ratio"].as<float>();
 
-    std::string type;
-    iss >> type; // "f"
+    // --bounds 境界ボリュームの出力
+    if (result.count("bounds")) convert.bounds = true;
 
-    std::vector<FaceIndex> result;
+    // --meshlets メッシュレットの作成
+    if (result.count("meshlets")) convert.meshlets = true;
 
-    std::string token;
-    while (iss >> token)
-    {
-        FaceIndex idx{ -1, -1, -1 };
-
-        std::istringstream tss(token);
-        std::string s;
-
-        // v
-        if (std::getline(tss, s, '/')) idx.v = fixIndex(std::stoi(s), static_cast<int>(object.positions.size()));
-
-        // vt
-        if (std::getline(tss, s, '/'))
-        {
-            if (!s.empty()) idx.vt = fixIndex(std::stoi(s), static_cast<int>(object.texcoords.size()));
-        }
-
-        // vn
-        if (std::getline(tss, s, '/'))
-        {
-            if (!s.empty()) idx.vn = fixIndex(std::stoi(s), static_cast<int>(object.normals.size()));
-        }
+    // --meshlet-vertices メッシュレットの最大頂点数
+    if (result.count("meshlet-vertices")) convert.meshletMaxVertices = result["meshlet-vertices"].as<uint32_t>();
 
-        result.push_back(idx);
-    }
+    // --meshlet-triangles メッシュレットの最大三角形数
+    if (result.count("meshlet-triangles")) convert.meshletMaxTriangles = result["meshlet-triangles"].as<uint32_t>();
 
-    return result;
-}
+    // --bvh BVHの作成
+    if (result.count("bvh")) convert.bvh = true;
 
-// objファイルの情報取得関数
-static int AnalyzeObj(const char* fname, Object& object)
-{
-    // objファイルのオープン
-    std::ifstream ifs(fname);
+    // --compress インデックス情報と頂点情報の圧縮
+    if (result.count("compress")) convert.compressGeometry = true;
 
-    if (!ifs)
+    // --section-codec セクションの圧縮形式
+    if (result.count("section-codec"))
     {
-        // ファイルのオープン失敗
-        std::cout << "Could not open " << fname << std::endl;
-        return 1;
+        std::string codec = result["section-codec"].as<std::string>();
+        if (codec == "xpress") convert.sectionCodec = SectionCodec_Xpress;
+        else if (codec == "xpress-huff") convert.sectionCodec = SectionCodec_XpressHuff;
+        else if (codec == "lzms") convert.sectionCodec = SectionCodec_Lzms;
+        else if (codec == "none") convert.sectionCodec = SectionCodec_None;
+        else throw std::runtime_error("Unknown section codec: " + codec);
     }
 
-    std::vector<Face>* pFace = nullptr;
-    std::string object_name;
-
-    std::string line;
-    while (std::getline(ifs, line))
-    {
-        // 空行やコメントをスキップ
-        if (line.empty() || line[0] == '#') continue;
-
-        std::istringstream iss(line);
-
-        // 先頭のトークン
-        std::string type;
-        iss >> type;
-
-        // オブジェクト名
-        if (type == "o")
-        {
-            iss >> object_name;
-            object.meshes.emplace_back();
-            pFace = nullptr;
-        }
-
-        // 頂点
-        if (type == "v")
-        {
-            object.positions.push_back(ReadFloat3(iss));
-        }
-
-        // 法線
-        else if (type == "vn")
-        {
-            object.normals.push_back(ReadFloat3(iss));
-        }
-
-        // テクスチャ座標
-        else if (type == "vt")
-        {
-            // BlenderのV座標は上が＋
-            XMFLOAT2 uv = ReadFloat2(iss);
-            uv.y = 1.0f - uv.y;
-            object.texcoords.push_back(uv);
-        }
+    // --section-ratio セクションを圧縮する比率
+    if (result.count("section-ratio")) convert.sectionRatio = result["section-ratio"].as<float>();
 
-        // 面情報
-        else if (type == "f")
-        {
-            // マテリアルがない
-            if (pFace == nullptr)
-            {
-                std::cout << object_name << " has no material assigned." << std::endl;
-                return 1;
-            }
+    // --chunked チャンク形式
+    if (result.count("chunked")) convert.chunked = true;
 
-            // 面の各頂点を構成するインデックスを取得
-            std::vector<FaceIndex> result = ParseFaceLine(line, object);
+    // --strips ストリップへの変換
+    if (result.count("strips")) convert.strips = true;
 
-            // 四角形の場合は三角形２枚に置き換える
-            for (size_t i = 0; i < result.size() - 2; i++)
-            {
-                // 時計回りが表
-                Face face{ result[0], result[i + 2], result[i + 1] };
-                pFace->push_back(face);
-            }
-        }
-
-        // マテリアル名
-        else if (type == "usemtl")
-        {
-            // メッシュを追加
-            object.meshes.back().subMeshs.emplace_back();
+    // --cache-dir 解析結果のキャッシュの保存先
+    if (result.count("cache-dir")) convert.cacheDirectory = result["cache-dir"].as<std::string>();
 
-            // マテリアル名
-            std::string material;
-            iss >> material;
-            object.meshes.back().subMeshs.back().material = material;
+    // --merge-materials 同じマテリアルのサブメッシュをまとめる
+    if (result.count("merge-materials")) convert.mergeMaterials = true;
 
-            // 面を設定するポインタを更新
-            pFace = &object.meshes.back().subMeshs.back().faces;
-        }
+    // --object-ranges オブジェクトごとの範囲の出力
+    if (result.count("object-ranges")) convert.objectRanges = true;
 
-        // マテリアルファイル名
-        else if (type == "mtllib")
-        {
-            iss >> object.mtllib;
-        }
-    }
+    // --extended-materials 拡張マテリアルを常に出力する
+    if (result.count("extended-materials")) convert.extendedMaterials = true;
 
-    return 0;
-}
+    // --dedup-materials 同じ内容のマテリアルをまとめる
+    if (result.count("dedup-materials")) convert.dedupMaterials = true;
 
-// テクスチャ名の登録関数
-static int32_t RegisterTextureName(std::istringstream& iss,
-    std::unordered_map<std::string, int32_t>& textureIndexMap,
-    std::vector<std::string>& textures,
-    int32_t& t_index
-)
-{
-    // 最後のトークンをファイル名として取得
-    std::string token, name;
-    while (iss >> token)
-    {
-        name = token;
-    }
+    // --strip-materials 使用していないマテリアルを取り除く
+    if (result.count("strip-materials")) convert.stripMaterials = true;
 
-    // エラー
-    if (name.empty()) return -1;
+    // --sort-meshes メッシュ情報を描画ステートの順に並べる
+    if (result.count("sort-meshes")) convert.sortMeshes = true;
 
-    // パス名を除去
-    name = GetFileNameOnly(name);
+    // --check-textures テクスチャのファイルを確認する
+    if (result.count("check-textures")) convert.checkTextures = true;
 
-    // 既に同じテクスチャ名が登録済みの場合も考慮
-    auto [it, inserted] = textureIndexMap.try_emplace(name, t_index);
+    // --crease-angle 法線を生成する場合の最大の角度
+    if (result.count("crease-angle")) convert.creaseAngle = result["crease-angle"].as<float>();
 
-    // 新しく挿入された
-    if (inserted)
-    {
-        t_index++;
-        textures.push_back(name);
-    }
+    // --nodes ノードの出力
+    if (result.count("nodes")) convert.nodes = true;
 
-    return it->second;
+    // --instancing 形状が同じノードの共有
+    if (result.count("instancing")) convert.instancing = true;
 }
 
-// mtlファイルの情報取得関数
-static int AnalyzeMtl( const char* fname,
-                       std::vector<MaterialInfo>& materials,
-                       std::unordered_map<std::string, uint32_t>& materialIndexMap,
-                       std::vector<std::string>& textures )
+// 引数から入力ファイル名と出力ファイル名を取得する関数
+static int AnalyzeOption(int argc, char* argv[], CommandOptions& command)
 {
-    // mtlファイルのオープン
-    std::ifstream ifs(fname);
-
-    if (!ifs)
-    {
-        // ファイルのオープン失敗
-        std::cout << "Could not open " << fname << std::endl;
-        return 1;
-    }
-
-    std::unordered_map<std::string, int32_t> textureIndexMap;
-
-    uint32_t m_index = 0;
-    int32_t t_index = 0;
+    // cxxoptsで引数解析
+    cxxopts::Options options("ObjToMdl");
+    options.add_options()
+        ("input", "Input model file (.obj)",
+            cxxopts::value<std::vector<std::string>>())
+        ("o,output", "Output file",
+            cxxopts::value<std::string>())
+        ("c,compare", "Reference .mdl file or directory",
+            cxxopts::value<std::string>())
+        ("t,tolerance", "Float tolerance for compare",
+            cxxopts::value<float>())
+        ("ignore-added-sections", "Ignore sections missing from the reference")
+        ("server", "Run as conversion server")
+        ("pipe", "Pipe name for server",
+            cxxopts::value<std::string>())
+        ("threads", "Worker threads for server",
+            cxxopts::value<unsigned int>())
+        ("max-request", "Max OBJ data size for server in MiB",
+            cxxopts::value<uint32_t>())
+        ("w,watch", "Directory to watch",
+            cxxopts::value<std::vector<std::string>>())
+        ("stats", "Print allocation counts")
+        ("lod", "LOD levels",
+            cxxopts::value<uint32_t>())
+        ("lod-ratio", "LOD triangle ratio",
+            cxxopts::value<float>())
+        ("bounds", "Write bounding volumes")
+        ("meshlets", "Generate meshlets")
+        ("meshlet-vertices", "Max vertices per meshlet",
+            cxxopts::value<uint32_t>())
+        ("meshlet-triangles", "Max triangles per meshlet",
+            cxxopts::value<uint32_t>())
+        ("bvh", "Generate BVH")
+        ("compress", "Compress index and vertex buffers")
+        ("benchmark", "Print compression benchmark")
+        ("section-codec", "Section compression codec",
+            cxxopts::value<std::string>())
+        ("section-ratio", "Section compression ratio threshold",
+            cxxopts::value<float>())
+        ("chunked", "Chunked layout")
+        ("strips", "Triangle strips")
+        ("cache-dir", "Parse cache directory",
+            cxxopts::value<std::string>())
+        ("merge-materials", "Merge submeshes by material")
+        ("object-ranges", "Write per-object ranges")
+        ("nodes", "Write scene nodes")
+        ("instancing", "Share identical node geometry")
+        ("extended-materials", "Always write extended materials")
+        ("dedup-materials", "Merge identical materials")
+        ("strip-materials", "Remove unused materials")
+        ("sort-meshes", "Sort meshes by render state")
+        ("check-textures", "Check texture files")
+        ("crease-angle", "Crease angle for generated normals",
+            cxxopts::value<float>())
+        ("pack", "Shared geometry pack file",
+            cxxopts::value<std::string>())
+        ("h,help", "Show help");
+    options.parse_positional({ "input" });
 
-    std::string line;
-    while (std::getline(ifs, line))
+    try
     {
-        // 空行やコメントをスキップ
-        if (line.empty() || line[0] == '#') continue;
-
-        std::istringstream iss(line);
-
-        // 先頭のトークン
-        std::string type;
-        iss >> type;
+        auto result = options.parse(argc, argv);
 
-        // マテリアルファイル名
-        if (type == "newmtl")
+        // -h,--help 指定された
+        if (result.count("help"))
         {
-            std::string name;
-            iss >> name;
-            materials.resize(materials.size() + 1);
-            materialIndexMap[name] = m_index;
-            m_index++;
+            Help();
+            return 0;
         }
 
-        // ディフューズ色
-        else if (type == "Kd")
-        {
-            materials.back().diffuseColor = ReadFloat3(iss);
-        }
+        // 変換オプション
+        AnalyzeConvertOption(result, command.convert);
 
-        // スペキュラ色
-        else if (type == "Ks")
+        // --server 常駐サーバー
+        if (result.count("server"))
         {
-            materials.back().specularColor = ReadFloat3(iss);
+            command.server = true;
+            if (result.count("pipe")) command.pipeName = result["pipe"].as<std::string>();
+            if (result.count("threads")) command.threads = result["threads"].as<unsigned int>();
+            if (result.count("max-request")) command.maxRequestMiB = result["max-request"].as<uint32_t>();
+            return 0;
         }
 
-        // スペキュラパワー
-        else if (type == "Ns")
+        // -w,--watch 監視モード
+        if (result.count("watch"))
         {
-            iss >> materials.back().specularPower;
+            command.watch = result["watch"].as<std::vector<std::string>>();
+            return 0;
         }
 
-        // エミッシブ色
-        else if (type == "Ke")
-        {
-            materials.back().emissiveColor = ReadFloat3(iss);
-        }
+        // 入力ファイル名
+        if (result.count("input") == 0) throw std::runtime_error("No input file");
+        command.inputs = result["input"].as<std::vector<std::string>>();
 
-        // テクスチャ（ベースカラー）
-        else if (type == "map_Kd")
+        // -o,-output 出力ファイル名
+        if (result.count("output"))
         {
-            if (!materials.empty())
-            {
-                materials.back().textureIndex_BaseColor = RegisterTextureName(iss, textureIndexMap, textures, t_index);
-            }
+            if (command.inputs.size() > 1) throw std::runtime_error("--output cannot be used with multiple inputs");
+            command.output = result["output"].as<std::string>();
         }
 
-        // テクスチャ（法線マップ）
-        else if (type == "map_Bump")
+        // -c,--compare 正解データ
+        if (result.count("compare"))
         {
-            if (!materials.empty())
+            command.compare = result["compare"].as<std::string>();
+            if (command.inputs.size() > 1 && !std::filesystem::is_directory(command.compare))
             {
-                materials.back().textureIndex_NormalMap = RegisterTextureName(iss, textureIndexMap, textures, t_index);
+                throw std::runtime_error("--compare must be a directory with multiple inputs");
             }
         }
-    }
 
-    return 0;
-}
+        // --stats メモリ確保回数の表示
+        command.stats = result.count("stats") > 0;
 
-// 頂点データ作成関数
-static VertexPositionNormalTextureTangent MakeVertex(Object& object, const FaceIndex& face)
-{
-    VertexPositionNormalTextureTangent v = {};
+        // --benchmark 圧縮率と展開速度の表示
+        command.benchmark = result.count("benchmark") > 0;
 
-    v.position = object.positions[face.v];
+        // --pack パックファイル名
+        if (result.count("pack")) command.pack = result["pack"].as<std::string>();
 
-    if (face.vn >= 0)
-    {
-        // 法線を正規化
-        XMVECTOR n = XMLoadFloat3(&object.normals[face.vn]);
-        n = XMVector3Normalize(n);
-        XMStoreFloat3(&v.normal, n);
+        // -t,--tolerance 許容誤差
+        if (result.count("tolerance"))
+        {
+            command.tolerance = result["tolerance"].as<float>();
+        }
+
+        // --ignore-added-sections 正解データにない拡張セクションを無視する
+        command.ignoreAddedSections = result.count("ignore-added-sections") > 0;
     }
-    else
+    catch (const std::exception& e)
     {
-        // ダミー
-        v.normal = XMFLOAT3(0.0f, 0.0f, 1.0f);
+        std::cerr << "Error: " << e.what() << std::endl;
+        Help();
+        return 1;
     }
 
-    v.texcoord = (face.vt >= 0) ? object.texcoords[face.vt] : XMFLOAT2(0.0f, 0.0f);
-
-    return v;
+    return 0;
 }
 
-static void CreateBufferData( Object& object, 
-                              std::unordered_map<std::string, uint32_t>& materialIndexMap,
-                              std::vector<MeshInfo>& meshInfo,
-                              std::vector<VertexPositionNormalTextureTangent>& vertexBuffer,
-                              std::vector<uint16_t>& indexBuffer )
+// 圧縮の計測結果
+struct BenchmarkResult
 {
-    std::unordered_map<FaceIndex, uint16_t> indexMap;
+    size_t rawBytes = 0;        // 圧縮前のサイズ
+    size_t encodedBytes = 0;    // 圧縮後のサイズ
+    double decodeSeconds = 0.0; // 展開時間
 
-    for (auto& mesh : object.meshes)
+    void Add(const BenchmarkResult& other)
     {
-        for (auto& subMesh : mesh.subMeshs)
-        {
-            // サブメッシュ情報
-            MeshInfo data = {};
-            auto it = materialIndexMap.find(subMesh.material);
-            if (it == materialIndexMap.end()) throw std::runtime_error("Material not found: " + subMesh.material);
-            data.materialIndex = it->second;                                // マテリアルインデックス
-            data.materialNameIndex = it->second;                            // マテリアル名インデックス
-            data.startIndex = static_cast<uint32_t>(indexBuffer.size());    // スタートインデックス
-            data.primCount = static_cast<uint32_t>(subMesh.faces.size());   // プリミティブ数
-            meshInfo.push_back(data);
-
-            for (auto& face : subMesh.faces)
-            {
-                for (int i = 0; i < 3; i++)
-                {
-                    auto it = indexMap.find(face.faceIndices[i]);
-
-                    if (it == indexMap.end())
-                    {
-                        // 新規頂点
-                        uint16_t newIndex = static_cast<uint16_t>(vertexBuffer.size());
-                        indexMap[face.faceIndices[i]] = newIndex;
-
-                        vertexBuffer.push_back(MakeVertex(object, face.faceIndices[i]));
-                        indexBuffer.push_back(newIndex);
-                    }
-                    else
-                    {
-                        // 既存頂点
-                        indexBuffer.push_back(it->second);
-                    }
-                }
-            }
-        }
+        rawBytes += other.rawBytes;
+        encodedBytes += other.encodedBytes;
+        decodeSeconds += other.decodeSeconds;
     }
-}
+};
 
-// ファイルへの出力関数
-static int OutputMdl( const char* fname,
-                      std::vector<MaterialInfo>& materials,
-                      std::vector<MeshInfo>& meshInfo,
-                      std::vector<std::string>& materialNames,
-                      std::vector<std::string>& textures,
-                      std::vector<VertexPositionNormalTextureTangent>& vertexBuffer,
-                      std::vector<uint16_t>& indexBuffer )
+// 展開を一定時間繰り返して1回あたりの時間を計測する関数
+template <class Decode>
+static double MeasureDecode(Decode decode)
 {
-    // mdlファイルのオープン
-    std::ofstream ofs(fname, std::ios::binary);
-
-    if (!ofs.is_open())
-    {
-        // ファイルのオープン失敗
-        std::cout << "Could not open " << fname << std::endl;
-        return 1;
-    }
-
-    // テクスチャ
-    uint32_t texture_cnt = static_cast<uint32_t>(textures.size());
-    ofs.write(reinterpret_cast<const char*>(&texture_cnt), sizeof(texture_cnt));
-    for (const auto& texture : textures)
+    using Clock = std::chrono::steady_clock;
+    int iterations = 0;
+    auto start = Clock::now();
+    std::chrono::duration<double> elapsed;
+    do
     {
-        uint32_t size = static_cast<uint32_t>(texture.size());
-        ofs.write(reinterpret_cast<const char*>(&size), sizeof(size));
-        ofs.write(texture.data(), size);
-    }
-
-    // マテリアル名テーブル
-    uint32_t materialName_cnt = static_cast<uint32_t>(materialNames.size());
-    ofs.write(reinterpret_cast<const char*>(&materialName_cnt), sizeof(materialName_cnt));
-    for (const auto& name : materialNames)
-    {
-        uint32_t len = static_cast<uint32_t>(name.size());
-        ofs.write(reinterpret_cast<const char*>(&len), sizeof(len));
-        ofs.write(name.data(), len);
-    }
-
-    // マテリアル
-    uint32_t material_cnt = static_cast<uint32_t>(materials.size());
-    ofs.write(reinterpret_cast<const char*>(&material_cnt), sizeof(material_cnt));
-    ofs.write(reinterpret_cast<const char*>(materials.data()), sizeof(MaterialInfo) * material_cnt);
-
-    // メッシュ情報
-    uint32_t mesh_cnt = static_cast<uint32_t>(meshInfo.size());
-    ofs.write(reinterpret_cast<const char*>(&mesh_cnt), sizeof(mesh_cnt));
-    ofs.write(reinterpret_cast<const char*>(meshInfo.data()), sizeof(MeshInfo) * mesh_cnt);
-
-    // インデックス
-    uint32_t index_cnt = static_cast<uint32_t>(indexBuffer.size());
-    ofs.write(reinterpret_cast<const char*>(&index_cnt), sizeof(index_cnt));
-    ofs.write(reinterpret_cast<const char*>(indexBuffer.data()), sizeof(uint16_t) * index_cnt);
-
-    // 頂点
-    uint32_t vertex_cnt = static_cast<uint32_t>(vertexBuffer.size());
-    ofs.write(reinterpret_cast<const char*>(&vertex_cnt), sizeof(vertex_cnt));
-    ofs.write(reinterpret_cast<const char*>(vertexBuffer.data()), sizeof(VertexPositionNormalTextureTangent) * vertex_cnt);
-
-    return 0;
-}
-
-// パス名を取得する関数
-static std::string GetDirectoryPath(const std::string& filepath)
-{
-    std::filesystem::path p(filepath);
-    return p.parent_path().string();
+        if (!decode()) throw std::runtime_error("Decode failed");
+        iterations++;
+        elapsed = Clock::now() - start;
+    } while (elapsed.count() < 0.1);
+    return elapsed.count() / iterations;
 }
 
-// パス名とファイル名を結合する関数
-static std::string JoinPath(const std::string& path, const std::string& filename)
+// 計測結果の表示
+static void PrintBenchmark(const std::string& name, const char* stream, const BenchmarkResult& result)
 {
-    std::filesystem::path p(path);
-    p /= filename;   // パス結合
-    return p.string();
+    double ratio = result.rawBytes ? 100.0 * result.encodedBytes / result.rawBytes : 0.0;
+    double speed = (result.decodeSeconds > 0.0) ? result.rawBytes / result.decodeSeconds / (1024.0 * 1024.0) : 0.0;
+    std::cout << name << ": " << stream << " " << result.rawBytes << " -> " << result.encodedBytes << " bytes ("
+              << std::fixed << std::setprecision(1) << ratio << "%), decode " << speed << " MB/s"
+              << std::defaultfloat << std::endl;
 }
 
-// 頂点データに接線を追加する関数
-static void GenerateTangents(
-    std::vector<VertexPositionNormalTextureTangent>& vertices,
-    const std::vector<uint16_t>& indices)
+// インデックス情報と頂点情報の圧縮率と展開速度を計測する関数
+static int Benchmark(const std::string& input, const std::string& output, BenchmarkResult& indexTotal, BenchmarkResult& vertexTotal)
 {
-    std::vector<XMFLOAT3> tanAccum(vertices.size(), { 0,0,0 });
-    std::vector<XMFLOAT3> bitanAccum(vertices.size(), { 0,0,0 });
-
-    auto add = [&](uint32_t idx, const XMFLOAT3& t, const XMFLOAT3& b)
-        {
-            tanAccum[idx].x += t.x;
-            tanAccum[idx].y += t.y;
-            tanAccum[idx].z += t.z;
-
-            bitanAccum[idx].x += b.x;
-            bitanAccum[idx].y += b.y;
-            bitanAccum[idx].z += b.z;
-        };
+    ModelData model;
+    if (ReadMdl(output.c_str(), model)) return 1;
 
-    auto set = [&](uint32_t idx, const XMFLOAT3& t, const XMFLOAT3& b)
-        {
-            tanAccum[idx] = t;
-            bitanAccum[idx] = b;
-        };
-
-    // 三角形の各頂点の法線が同じ向きならフラットシェーディングの面と判定
-    auto isFlatFace = [&](uint32_t i0, uint32_t i1, uint32_t i2)
-        {
-            XMVECTOR n0 = XMLoadFloat3(&vertices[i0].normal);
-            XMVECTOR n1 = XMLoadFloat3(&vertices[i1].normal);
-            XMVECTOR n2 = XMLoadFloat3(&vertices[i2].normal);
-
-            float d01 = XMVectorGetX(XMVector3Dot(n0, n1));
-            float d12 = XMVectorGetX(XMVector3Dot(n1, n2));
-
-            return d01 > 0.999f && d12 > 0.999f;
-        };
-
-    // ---- 三角形ごと ----
-    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    try
     {
-        uint32_t i0 = indices[i + 0];
-        uint32_t i1 = indices[i + 1];
-        uint32_t i2 = indices[i + 2];
-
-        auto& v0 = vertices[i0];
-        auto& v1 = vertices[i1];
-        auto& v2 = vertices[i2];
-
-        XMVECTOR p0 = XMLoadFloat3(&v0.position);
-        XMVECTOR p1 = XMLoadFloat3(&v1.position);
-        XMVECTOR p2 = XMLoadFloat3(&v2.position);
-
-        float du1 = v1.texcoord.x - v0.texcoord.x;
-        float dv1 = v1.texcoord.y - v0.texcoord.y;
-        float du2 = v2.texcoord.x - v0.texcoord.x;
-        float dv2 = v2.texcoord.y - v0.texcoord.y;
-
-        float denom = du1 * dv2 - du2 * dv1;
-        if (fabs(denom) < 1e-6f)
-            continue;
-
-        float f = 1.0f / denom;
-
-        XMVECTOR e1 = p1 - p0;
-        XMVECTOR e2 = p2 - p0;
-
-        XMVECTOR T = (e1 * dv2 - e2 * dv1) * f;
-        XMVECTOR B = (e2 * du1 - e1 * du2) * f;
-
-        XMFLOAT3 t, b;
-        XMStoreFloat3(&t, T);
-        XMStoreFloat3(&b, B);
-
-        bool flat = isFlatFace(i0, i1, i2);
-
-        if (flat)
-        {
-            // フラット：上書き
-            set(i0, t, b);
-            set(i1, t, b);
-            set(i2, t, b);
-        }
-        else
-        {
-            // スムーズ：加算
-            add(i0, t, b);
-            add(i1, t, b);
-            add(i2, t, b);
-        }
+        std::vector<char> encoded;
+        std::vector<uint16_t> indices;
+        BenchmarkResult index;
+        EncodeIndexBuffer(model.indexBuffer.data(), model.indexBuffer.size(), encoded);
+        index.rawBytes = sizeof(uint16_t) * model.indexBuffer.size();
+        index.encodedBytes = encoded.size();
+        index.decodeSeconds = MeasureDecode([&]() { return DecodeIndexBuffer(encoded.data(), encoded.size(), indices); });
+        if (indices != model.indexBuffer) throw std::runtime_error("Index buffer mismatch");
+
+        encoded.clear();
+        std::vector<VertexPositionNormalTextureTangent> vertices;
+        BenchmarkResult vertex;
+        EncodeVertexBuffer(model.vertexBuffer, encoded);
+        vertex.rawBytes = sizeof(VertexPositionNormalTextureTangent) * model.vertexBuffer.size();
+        vertex.encodedBytes = encoded.size();
+        vertex.decodeSeconds = MeasureDecode([&]() { return DecodeVertexBuffer(encoded.data(), encoded.size(), vertices); });
+        if (memcmp(vertices.data(), model.vertexBuffer.data(), vertex.rawBytes) != 0) throw std::runtime_error("Vertex buffer mismatch");
+
+        PrintBenchmark(input, "indices ", index);
+        PrintBenchmark(input, "vertices", vertex);
+        indexTotal.Add(index);
+        vertexTotal.Add(vertex);
     }
-
-    // ---- 正規化 & handedness ----
-    for (size_t i = 0; i < vertices.size(); i++)
+    catch (const std::exception& e)
     {
-        XMVECTOR N = XMLoadFloat3(&vertices[i].normal);
-        XMVECTOR T = XMLoadFloat3(&tanAccum[i]);
-        XMVECTOR B = XMLoadFloat3(&bitanAccum[i]);
-
-        T = XMVector3Normalize(T - N * XMVector3Dot(N, T));
-
-        float w = (XMVectorGetX(
-            XMVector3Dot(XMVector3Cross(N, T), B)) < 0.0f)
-            ? -1.0f : 1.0f;
-
-        XMFLOAT3 t;
-        XMStoreFloat3(&t, T);
-        vertices[i].tangent = { t.x, t.y, t.z, w };
+        std::cout << input << ": Error: " << e.what() << std::endl;
+        return 1;
     }
+
+    return 0;
 }
 
 // メイン
@@ -750,47 +428,109 @@ int wmain(int argc, wchar_t* wargv[])
         argv.push_back(s.data());
     }
 
-    std::string input, output;
+    CommandOptions command;
 
     // 入力ファイル名と出力ファイル名を取得
-    if (AnalyzeOption(argc, argv.data(), input, output)) return 1;
+    if (AnalyzeOption(argc, argv.data(), command)) return 1;
 
-    // ----- 情報取得 ----- //
+    const ConvertOptions& options = command.convert;
 
-    Object object;
- 
-    // objファイルの情報取得
-    if (AnalyzeObj(input.c_str(), object)) return 1;
-
-    // mtlファイルの情報取得
-    object.mtllib = JoinPath(GetDirectoryPath(input), object.mtllib);
+    // 常駐サーバーとして起動
+    if (command.server)
+    {
+        // 4GiB未満に収める
+        uint32_t maxObjSize = static_cast<uint32_t>(std::min<uint64_t>(uint64_t(command.maxRequestMiB) * 1024 * 1024, UINT32_MAX));
+        return RunServer(command.pipeName, command.threads, maxObjSize, options);
+    }
 
-    // マテリアルを取得
-    std::vector<MaterialInfo> materials;
-    std::unordered_map<std::string, uint32_t> materialIndexMap;
-    std::vector<std::string> textures;
-    if (AnalyzeMtl(object.mtllib.c_str(), materials, materialIndexMap, textures)) return 1;
+    // 監視モードで起動
+    if (!command.watch.empty()) return RunWatch(command.watch, options);
 
-    // マテリアル名の配列を作成
-    std::vector<std::string> materialNames(materials.size());
-    for (const auto& [name, index] : materialIndexMap)
+    // パックファイル（すべての入力ファイルで同じ内容のインデックス情報と頂点情報を共有する）
+    GeometryPack pack;
+    if (!command.pack.empty())
     {
-        materialNames[index] = name;
+        if (!pack.Open(command.pack))
+        {
+            std::cout << "Could not open " << command.pack << std::endl;
+            return 1;
+        }
+        command.convert.geometryPack = &pack;
     }
 
-    // 頂点、インデックスを取得
-    std::vector<MeshInfo> meshInfo;
-    std::vector<VertexPositionNormalTextureTangent> vertexBuffer;
-    std::vector<uint16_t> indexBuffer;
-    CreateBufferData(object, materialIndexMap, meshInfo, vertexBuffer, indexBuffer);
+    int failed = 0;
+    BenchmarkResult indexTotal, vertexTotal;
 
-    // 頂点データに接線を追加
-    GenerateTangents(vertexBuffer, indexBuffer);
+    for (const auto& input : command.inputs)
+    {
+        // 出力ファイル名が指定されていない場合は、入力ファイル名.mdlにする
+        std::string output = command.output;
+        if (output.empty())
+        {
+            std::filesystem::path p(input);
+            p.replace_extension(".mdl");
+            output = p.string();
+        }
 
-    // ----- 書き出し ----- //
+        InputSource source;
+        source.path = input;
 
-    if (OutputMdl(output.c_str(), materials, meshInfo, materialNames, textures, vertexBuffer, indexBuffer)) return 1;
+        OutputSink sink;
+        sink.path = output;
 
-    return 0;
-}
+        ConvertResult result;
+        if (Convert(options, source, sink, &result))
+        {
+            failed++;
+            continue;
+        }
+
+        // メモリ確保回数
+        if (command.stats)
+        {
+            std::cout << input << ": " << result.allocationRequests << " allocations, "
+                      << result.heapAllocations << " from heap (" << result.heapBytes << " bytes)"
+                      << (result.fromCache ? ", from cache" : "") << std::endl;
+        }
+
+        // 正解データと比較
+        if (!command.compare.empty())
+        {
+            std::string reference = command.compare;
+            if (std::filesystem::is_directory(reference))
+            {
+                reference = (std::filesystem::path(reference) / std::filesystem::path(output).filename()).string();
+            }
 
+            ModelData expected, actual;
+            if (ReadMdl(reference.c_str(), expected) || ReadMdl(output.c_str(), actual)
+                || CompareMdl(expected, actual, command.tolerance, command.ignoreAddedSections))
+            {
+                std::cout << input << ": FAILED" << std::endl;
+                failed++;
+                continue;
+            }
+            std::cout << input << ": OK" << std::endl;
+        }
+
+        // 圧縮率と展開速度
+        if (command.benchmark && Benchmark(input, output, indexTotal, vertexTotal))
+        {
+            failed++;
+        }
+    }
+
+    if (command.benchmark)
+    {
+        PrintBenchmark("Total", "indices ", indexTotal);
+        PrintBenchmark("Total", "vertices", vertexTotal);
+    }
+
+    if (command.stats && !command.pack.empty())
+    {
+        std::cout << command.pack << ": " << pack.GetBlobCount() << " blobs, " << pack.GetSize() << " bytes ("
+                  << pack.GetSharedBytes() << " bytes shared)" << std::endl;
+    }
+
+    return failed ? 1 : 0;
+}
@@ -42,4 +42,193 @@ namespace ObjToImdl
         DirectX::XMFLOAT2 texcoord;    // eNX`W
         DirectX::XMFLOAT4 tangent;     // xyz = ڐ, w = ]ڐ̌𒲐i1,-1)
     };
+
+    // gZNVIDi_̌ɑȗ\ȃf[^j
+    constexpr uint32_t MakeSectionId(char a, char b, char c, char d)
+    {
+        return static_cast<uint32_t>(static_cast<uint8_t>(a))
+             | static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8
+             | static_cast<uint32_t>(static_cast<uint8_t>(c)) << 16
+             | static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24;
+    }
+
+    constexpr uint32_t SectionId_Lod = MakeSectionId('L', 'O', 'D', ' ');        // LOD
+    constexpr uint32_t SectionId_Meshlet = MakeSectionId('M', 'S', 'H', 'L');    // bVbg
+    constexpr uint32_t SectionId_Bounds = MakeSectionId('B', 'N', 'D', 'S');     // E{[
+    constexpr uint32_t SectionId_Bvh = MakeSectionId('B', 'V', 'H', ' ');        // BVH
+    constexpr uint32_t SectionId_IndexCodec = MakeSectionId('I', 'D', 'X', 'C'); // kCfbNX
+    constexpr uint32_t SectionId_VertexCodec = MakeSectionId('V', 'T', 'X', 'C');// k_
+    constexpr uint32_t SectionId_IndexBuffer = MakeSectionId('I', 'B', 'U', 'F');// CfbNX
+    constexpr uint32_t SectionId_VertexBuffer = MakeSectionId('V', 'B', 'U', 'F');// _
+    constexpr uint32_t SectionId_Compressed = MakeSectionId('Z', 'S', 'E', 'C'); // kZNV
+    constexpr uint32_t SectionId_ChunkTable = MakeSectionId('C', 'H', 'N', 'K'); // `Ne[u
+    constexpr uint32_t SectionId_ChunkData = MakeSectionId('C', 'D', 'A', 'T');  // `Nf[^
+    constexpr uint32_t SectionId_Topology = MakeSectionId('T', 'O', 'P', 'O');   // v~eBǔ`
+    constexpr uint32_t SectionId_ObjectRanges = MakeSectionId('O', 'B', 'J', 'R');// IuWFNgƂ͈̔
+    constexpr uint32_t SectionId_Nodes = MakeSectionId('N', 'O', 'D', 'E');      // m[h
+    constexpr uint32_t SectionId_PackReference = MakeSectionId('P', 'R', 'E', 'F');// pbNt@C̎Q
+    constexpr uint32_t SectionId_MaterialEx = MakeSectionId('M', 'T', 'L', 'X');  // g}eA
+
+    // ZNV̈k`
+    constexpr uint32_t SectionCodec_None = 0;           // kȂ
+    constexpr uint32_t SectionCodec_Xpress = 1;         // XPRESSiWJj
+    constexpr uint32_t SectionCodec_XpressHuff = 2;     // XPRESS + nt}
+    constexpr uint32_t SectionCodec_Lzms = 3;           // LZMSikj
+
+    // E{[
+    struct BoundingVolume
+    {
+        DirectX::XMFLOAT3 aabbMin;  // sE{bNX̍ŏl
+        DirectX::XMFLOAT3 aabbMax;  // sE{bNX̍ől
+        DirectX::XMFLOAT3 center;   // E̒S
+        float radius;               // E̔a
+    };
+
+    // LOD
+    struct LodInfo
+    {
+        uint32_t startIndex;        // X^[gCfbNX
+        uint32_t primCount;         // v~eBu
+        float error;                // ȗɂ덷ifԂł̋j
+    };
+
+    // bVbg
+    struct Meshlet
+    {
+        uint32_t vertexOffset;      // _CfbNX̊Jnʒu
+        uint32_t triangleOffset;    // [JCfbNX̊JnʒuiOp`Pʁj
+        uint32_t vertexCount;       // _
+        uint32_t triangleCount;     // Op`
+        DirectX::XMFLOAT3 center;   // E̒S
+        float radius;               // E̔a
+        DirectX::XMFLOAT3 coneApex; // @R[̒_
+        DirectX::XMFLOAT3 coneAxis; // @R[̎i_̖@Ɠj
+        float coneCutoff;           // dot(normalize(coneApex - _), coneAxis) >= coneCutoff Ȃ痠
+    };
+
+    // bV񂲂Ƃ̃bVbg͈̔
+    struct MeshletRange
+    {
+        uint32_t firstMeshlet;      // ŏ̃bVbg
+        uint32_t meshletCount;      // bVbg
+    };
+
+    // BVH̃m[hi[D揇ɕсA̎q͒̃m[hj
+    struct BvhNode
+    {
+        DirectX::XMFLOAT3 boundsMin;    // E{bNX̍ŏl
+        uint32_t offset;                // tFŏ̃v~eBuA߁FE̎q̃m[hԍ
+        DirectX::XMFLOAT3 boundsMax;    // E{bNX̍ől
+        uint16_t primCount;             // v~eBui0̏ꍇ͐߁j
+        uint16_t axis;                  // ߁Fi0:x 1:y 2:zj
+    };
+
+    // `NibV܂LOD̃xƂ̒_ƃCfbNXj
+    struct ChunkInfo
+    {
+        uint32_t meshIndex;         // bV̔ԍ
+        uint32_t lodLevel;          // LOD̃xi0̓bV͈̔́j
+        uint32_t offset;            // `Nf[^ZNṼf[^̐擪̈ʒu
+        uint32_t size;              // f[^̃TCYi4̔{j
+        uint32_t vertexCount;       // _if[^̐擪ɒ_񂪕ԁj
+        uint32_t indexCount;        // CfbNXi_̌ɕԁA`N̒_ԍj
+    };
+
+    // v~eBǔ`
+    constexpr uint32_t Topology_TriangleList = 0;       // Op`Xg
+    constexpr uint32_t Topology_TriangleStrip = 1;      // gCAOXgbvi0xFFFFōĊJj
+
+    // bV񂲂Ƃ̃v~eBǔ`
+    struct MeshTopology
+    {
+        uint32_t topology;          // v~eBǔ`iTopology_*j
+        uint32_t indexCount;        // CfbNXiĊJ̃CfbNX܂ށj
+    };
+
+    // bV̒̃IuWFNgiobjt@CojƂ͈̔́i}eA܂Ƃ߂ꍇ̃sbLOpj
+    struct ObjectRange
+    {
+        uint32_t objectIndex;       // IuWFNg̔ԍiobjt@Cł̏ԁj
+        uint32_t meshInfoIndex;     // bV̔ԍ
+        uint32_t firstPrim;         // bV̐擪̃v~eBüʒu
+        uint32_t primCount;         // v~eBu
+    };
+
+    // m[hiobjt@CoAgƁj
+    struct NodeInfo
+    {
+        int32_t parent;                     // em[h̔ԍiȂꍇ-1j
+        uint32_t meshStart;                 // bV̊Jnԍ
+        uint32_t meshCount;                 // bV̐
+        uint32_t instanceOf;                // `Lm[h̔ԍiLȂꍇ͎̔ԍj
+        DirectX::XMFLOAT3 translation;      // `Lm[ḧړ
+    };
+
+    // pbNt@C̎ʎqi擪ɒuj
+    constexpr uint32_t PackFileMagic = MakeSectionId('G', 'P', 'A', 'K');
+    constexpr uint32_t PackFileVersion = 1;
+
+    // pbNt@C̃f[^̈ʒu
+    struct PackBlob
+    {
+        uint64_t offset;            // t@C̐擪̈ʒu
+        uint64_t size;              // TCY
+    };
+
+    // g}eÃtOi`揇̕בւpj
+    constexpr uint32_t MaterialFlag_Transparent = 1 << 0;   // id1A܂map_dj
+    constexpr uint32_t MaterialFlag_Pbr = 1 << 1;           // PBR̃p[^iPrAPmAmap_PrAmap_Pmj
+
+    // g}eAiMaterialInfoɂȂmtlt@C̃p[^A}eAƓɕԁj
+    struct MaterialInfoEx
+    {
+        DirectX::XMFLOAT3 ambientColor;         // ArGgFiKaj
+        float opacity;                          // sxidATȑꍇ1 - Trj
+        DirectX::XMFLOAT3 transmissionFilter;   // ߃tB^[iTfj
+        float refractionIndex;                  // ܗiNij
+        uint32_t illuminationModel;             // Ɩfiillumj
+        float roughness;                        // tlXiPrj
+        float metallic;                         // ^bNiPmj
+        float sheen;                            // V[iPsj
+        float clearcoatThickness;               // NAR[ǧiPcj
+        float clearcoatRoughness;               // NAR[g̃tlXiPcrj
+        float anisotropy;                       // ٕianisoj
+        float anisotropyRotation;               // ٕ̉]ianisorj
+        int32_t textureIndex_Ambient;           // eNX`CfbNXimap_Kaj
+        int32_t textureIndex_Specular;          // eNX`CfbNXimap_Ksj
+        int32_t textureIndex_SpecularPower;     // eNX`CfbNXimap_Nsj
+        int32_t textureIndex_Opacity;           // eNX`CfbNXimap_dj
+        int32_t textureIndex_Emissive;          // eNX`CfbNXimap_Kej
+        int32_t textureIndex_Roughness;         // eNX`CfbNXimap_Prj
+        int32_t textureIndex_Metallic;          // eNX`CfbNXimap_Pmj
+        int32_t textureIndex_Sheen;             // eNX`CfbNXimap_Psj
+        int32_t textureIndex_Displacement;      // eNX`CfbNXidispj
+        uint32_t flags;                         // MaterialFlag_*̑gݍ킹
+
+        MaterialInfoEx()
+            : ambientColor{ 1.0f, 1.0f, 1.0f }
+            , opacity{ 1.0f }
+            , transmissionFilter{ 1.0f, 1.0f, 1.0f }
+            , refractionIndex{ 1.0f }
+            , illuminationModel{ 2 }
+            , roughness{ 1.0f }
+            , metallic{ 0.0f }
+            , sheen{ 0.0f }
+            , clearcoatThickness{ 0.0f }
+            , clearcoatRoughness{ 0.0f }
+            , anisotropy{ 0.0f }
+            , anisotropyRotation{ 0.0f }
+            , textureIndex_Ambient{ -1 }
+            , textureIndex_Specular{ -1 }
+            , textureIndex_SpecularPower{ -1 }
+            , textureIndex_Opacity{ -1 }
+            , textureIndex_Emissive{ -1 }
+            , textureIndex_Roughness{ -1 }
+            , textureIndex_Metallic{ -1 }
+            , textureIndex_Sheen{ -1 }
+            , textureIndex_Displacement{ -1 }
+            , flags{ 0 }
+        {
+        }
+    };
 }
@@ -0,0 +1,190 @@
+﻿// Pack.cpp : 複数のモデルで同じインデックス情報と頂点情報を共有するパックファイル
+//
+// パックファイルの形式
+//      識別子(uint32_t)                  PackFileMagic
+//      バージョン(uint32_t)              PackFileVersion
+//      |データ(char * size)              |*cnt   PackAlignment境界まで0で埋める
+//      データの位置はmdlファイルの参照セクションにあるので、パックファイルには目次を持たない
+//      （変換中のモデルからも読めるようにデータは追加するたびに書き込む）
+//
+// パックファイルの参照セクション（'PREF'）
+//      インデックス情報の位置(PackBlob)
+//      頂点情報の位置(PackBlob)
+//      パックファイル名の文字数(uint32_t)
+//      パックファイル名(char)            mdlファイルのディレクトリからの相対パス（UTF-8）
+
+#include "Pack.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+using namespace ObjToImdl;
+
+constexpr uint64_t PackAlignment = 16;  // データの先頭の境界
+
+// データのハッシュ値（FNV-1a）を求める関数
+static uint64_t HashData(const void* data, size_t size)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= static_cast<const unsigned char*>(data)[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// パックファイルを作成する関数
+bool GeometryPack::Open(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_reader.is_open()) m_reader.close();
+    if (m_file.is_open()) m_file.close();
+    m_file.clear();
+    m_file.open(std::filesystem::u8path(path), std::ios::binary | std::ios::trunc);
+    if (!m_file.is_open()) return false;
+
+    uint32_t header[2] = { PackFileMagic, PackFileVersion };
+    m_file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    m_file.flush();
+
+    // 共有するデータの比較は書き込んだファイルから読み戻して行う（データをメモリに保持しない）
+    m_reader.clear();
+    m_reader.open(std::filesystem::u8path(path), std::ios::binary);
+    if (!m_reader.is_open()) return false;
+
+    m_path = path;
+    m_size = sizeof(header);
+    m_sharedBytes = 0;
+    m_hashMap.clear();
+    m_positions.clear();
+    return static_cast<bool>(m_file);
+}
+
+// 書き込んだデータとdataの内容が同じかを調べる関数
+bool GeometryPack::Equals(const PackBlob& blob, const void* data, size_t size)
+{
+    if (blob.size != size) return false;
+
+    m_reader.clear();
+    m_reader.seekg(static_cast<std::streamoff>(blob.offset));
+
+    char buffer[16384];
+    for (size_t pos = 0; pos < size; pos += sizeof(buffer))
+    {
+        size_t len = std::min(size - pos, sizeof(buffer));
+        if (!m_reader.read(buffer, static_cast<std::streamsize>(len))) throw std::runtime_error("Could not read " + m_path);
+        if (memcmp(buffer, static_cast<const char*>(data) + pos, len) != 0) return false;
+    }
+    return true;
+}
+
+// データを追加して位置を返す関数
+PackBlob GeometryPack::Add(const void* data, size_t size)
+{
+    uint64_t hash = HashData(data, size);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // 同じ内容のデータがあれば共有する
+    auto range = m_hashMap.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (Equals(m_positions[it->second], data, size))
+        {
+            m_sharedBytes += size;
+            return m_positions[it->second];
+        }
+    }
+
+    // 境界まで0で埋めてから書き込む
+    static const char padding[PackAlignment] = {};
+    uint64_t offset = (m_size + PackAlignment - 1) / PackAlignment * PackAlignment;
+    m_file.write(padding, offset - m_size);
+    m_file.write(static_cast<const char*>(data), size);
+    m_file.flush();
+    if (!m_file) throw std::runtime_error("Could not write " + m_path);
+
+    PackBlob position = { offset, size };
+    m_size = offset + size;
+    m_hashMap.emplace(hash, m_positions.size());
+    m_positions.push_back(position);
+    return position;
+}
+
+size_t GeometryPack::GetBlobCount()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_positions.size();
+}
+
+uint64_t GeometryPack::GetSize()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_size;
+}
+
+uint64_t GeometryPack::GetSharedBytes()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_sharedBytes;
+}
+
+// パックファイルの参照セクションの内容を作成する関数
+void ObjToImdl::WritePackReference(const std::string& mdlPath, const std::string& packPath,
+                                   const PackBlob& indices, const PackBlob& vertices, std::vector<char>& out)
+{
+    // mdlファイルのディレクトリからの相対パス（求められない場合はファイル名のみ）
+    std::error_code ec;
+    std::filesystem::path pack = std::filesystem::absolute(std::filesystem::u8path(packPath), ec);
+    std::filesystem::path directory = std::filesystem::absolute(std::filesystem::u8path(mdlPath), ec).parent_path();
+    std::string name = mdlPath.empty() ? std::string() : pack.lexically_relative(directory).generic_u8string();
+    if (name.empty()) name = pack.filename().generic_u8string();
+
+    uint32_t len = static_cast<uint32_t>(name.size());
+    size_t pos = out.size();
+    out.resize(pos + sizeof(PackBlob) * 2 + sizeof(len) + len);
+    memcpy(&out[pos], &indices, sizeof(PackBlob));
+    memcpy(&out[pos + sizeof(PackBlob)], &vertices, sizeof(PackBlob));
+    memcpy(&out[pos + sizeof(PackBlob) * 2], &len, sizeof(len));
+    memcpy(&out[pos + sizeof(PackBlob) * 2 + sizeof(len)], name.data(), len);
+}
+
+// パックファイルの参照セクションからインデックス情報と頂点情報を読み込む関数
+bool ObjToImdl::ReadPackReference(const std::string& mdlPath, const char* data, size_t size,
+                                  std::vector<uint16_t>& indices,
+                                  std::vector<VertexPositionNormalTextureTangent>& vertices)
+{
+    PackBlob blobs[2];  // インデックス情報、頂点情報
+    uint32_t len;
+    if (size < sizeof(blobs) + sizeof(len)) return false;
+    memcpy(blobs, data, sizeof(blobs));
+    memcpy(&len, data + sizeof(blobs), sizeof(len));
+    if (size - sizeof(blobs) - sizeof(len) != len) return false;
+    std::string name(data + sizeof(blobs) + sizeof(len), len);
+
+    std::filesystem::path path = std::filesystem::u8path(mdlPath).parent_path() / std::filesystem::u8path(name);
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs)
+    {
+        std::cout << "Could not open " << path.u8string() << std::endl;
+        return false;
+    }
+
+    uint32_t header[2] = {};
+    ifs.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!ifs || header[0] != PackFileMagic || header[1] != PackFileVersion) return false;
+
+    auto readBlob = [&](const PackBlob& blob, auto& array) {
+        if (blob.size % sizeof(array[0]) != 0) return false;
+        array.resize(static_cast<size_t>(blob.size / sizeof(array[0])));
+        ifs.seekg(static_cast<std::streamoff>(blob.offset));
+        ifs.read(reinterpret_cast<char*>(array.data()), static_cast<std::streamsize>(blob.size));
+        return static_cast<bool>(ifs);
+    };
+
+    return readBlob(blobs[0], indices) && readBlob(blobs[1], vertices);
+}
@@ -0,0 +1,52 @@
+﻿// Pack.h : 複数のモデルで同じインデックス情報と頂点情報を共有するパックファイル
+
+#pragma once
+
+#include "ObjToMdl.h"
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ObjToImdl
+{
+    // 同じ内容のデータを１つにまとめて書き込むパックファイル（複数のスレッドから追加できる）
+    class GeometryPack
+    {
+    public:
+        // パックファイルを作成する関数（失敗時はfalse）
+        bool Open(const std::string& path);
+
+        // データを追加して位置を返す関数（同じ内容のデータがあればその位置を返す）
+        PackBlob Add(const void* data, size_t size);
+
+        const std::string& GetPath() const { return m_path; }
+        size_t GetBlobCount();      // 書き込んだデータの数
+        uint64_t GetSize();         // パックファイルのサイズ
+        uint64_t GetSharedBytes();  // 共有して書き込まなかったデータのサイズ
+
+    private:
+        // 書き込んだデータとdataの内容が同じかを調べる関数
+        bool Equals(const PackBlob& blob, const void* data, size_t size);
+
+        std::mutex m_mutex;
+        std::ofstream m_file;
+        std::ifstream m_reader;     // 書き込んだデータの読み込み用（内容の比較用）
+        std::string m_path;
+        uint64_t m_size = 0;
+        uint64_t m_sharedBytes = 0;
+        std::unordered_multimap<uint64_t, size_t> m_hashMap;    // ハッシュ値 → データの番号
+        std::vector<PackBlob> m_positions;                      // 書き込んだデータの位置
+    };
+
+    // パックファイルの参照セクションの内容を作成する関数（パックファイル名はmdlファイルからの相対パスにする）
+    void WritePackReference(const std::string& mdlPath, const std::string& packPath,
+                            const PackBlob& indices, const PackBlob& vertices, std::vector<char>& out);
+
+    // パックファイルの参照セクションからインデックス情報と頂点情報を読み込む関数（失敗時はfalse）
+    bool ReadPackReference(const std::string& mdlPath, const char* data, size_t size,
+                           std::vector<uint16_t>& indices,
+                           std::vector<VertexPositionNormalTextureTangent>& vertices);
+}
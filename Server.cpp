@@ -0,0 +1,221 @@
+﻿// Server.cpp : 名前付きパイプで変換要求を受け付ける常駐サーバー
+
+// ------------------------------------------------------------ //
+// 通信フォーマット（\\.\pipe\<パイプ名>、１接続で複数の要求を送信可能）
+//
+// 要求
+//      objファイル名の文字数(uint32_t)
+//      objファイル名(char, UTF-8)        mtlファイルはこのファイルのディレクトリから検索
+//      objデータのサイズ(uint32_t)       0の場合はobjファイル名から読み込む
+//      objデータ(char)
+//
+// 応答
+//      結果(uint32_t)                    0:成功 1:失敗 2:要求が大きすぎる（応答後に切断する）
+//      mdlデータのサイズ(uint32_t)
+//      mdlデータ(char)
+//
+// パイプはリモートのクライアントを拒否し、サーバーと同じユーザー、SYSTEM、Administratorsのみ接続できる
+// ------------------------------------------------------------ //
+
+#include "Server.h"
+#include <iostream>
+#include <windows.h>
+#include <sddl.h>
+#include <thread>
+#include <vector>
+
+using namespace ObjToImdl;
+
+constexpr uint32_t MaxPathSize = MAX_PATH * 4;  // objファイル名の最大の文字数（UTF-8）
+
+// 要求の結果
+constexpr uint32_t Result_Succeeded = 0;
+constexpr uint32_t Result_Failed = 1;
+constexpr uint32_t Result_TooLarge = 2;
+
+// 指定サイズを読み込むまで待つ関数
+static bool ReadExact(HANDLE pipe, void* data, size_t size)
+{
+    char* p = static_cast<char*>(data);
+    while (size > 0)
+    {
+        DWORD read = 0;
+        if (!ReadFile(pipe, p, static_cast<DWORD>(size), &read, nullptr) || read == 0) return false;
+        p += read;
+        size -= read;
+    }
+    return true;
+}
+
+// 指定サイズを書き込む関数
+static bool WriteExact(HANDLE pipe, const void* data, size_t size)
+{
+    const char* p = static_cast<const char*>(data);
+    while (size > 0)
+    {
+        DWORD written = 0;
+        if (!WriteFile(pipe, p, static_cast<DWORD>(size), &written, nullptr) || written == 0) return false;
+        p += written;
+        size -= written;
+    }
+    return true;
+}
+
+// 大きすぎる要求を拒否する関数（残りのデータを読まないので応答後に切断する）
+static void RejectRequest(HANDLE pipe)
+{
+    uint32_t reply[2] = { Result_TooLarge, 0 };     // 結果、mdlデータのサイズ
+    WriteExact(pipe, reply, sizeof(reply));
+}
+
+// 接続中のクライアントの要求を処理する関数（切断されると戻る）
+static void ServeClient(HANDLE pipe, uint32_t maxObjSize, const ConvertOptions& options, std::string& objPath, std::vector<char>& objData, std::vector<char>& mdl)
+{
+    for (;;)
+    {
+        // 要求の受信（確保する前にサイズを確認する）
+        uint32_t pathSize = 0;
+        if (!ReadExact(pipe, &pathSize, sizeof(pathSize))) return;
+        if (pathSize > MaxPathSize)
+        {
+            RejectRequest(pipe);
+            return;
+        }
+        objPath.resize(pathSize);
+        if (!ReadExact(pipe, objPath.data(), pathSize)) return;
+
+        uint32_t dataSize = 0;
+        if (!ReadExact(pipe, &dataSize, sizeof(dataSize))) return;
+        if (dataSize > maxObjSize)
+        {
+            RejectRequest(pipe);
+            return;
+        }
+        objData.resize(dataSize);
+        if (!ReadExact(pipe, objData.data(), dataSize)) return;
+
+        // 変換
+        InputSource source;
+        source.path = objPath;
+        if (dataSize > 0)
+        {
+            source.data = objData.data();
+            source.size = objData.size();
+        }
+
+        OutputSink sink;
+        sink.buffer = &mdl;
+
+        uint32_t result = Convert(options, source, sink) ? Result_Failed : Result_Succeeded;
+        if (result) mdl.clear();
+
+        // 応答の送信
+        uint32_t mdlSize = static_cast<uint32_t>(mdl.size());
+        if (!WriteExact(pipe, &result, sizeof(result))
+            || !WriteExact(pipe, &mdlSize, sizeof(mdlSize))
+            || !WriteExact(pipe, mdl.data(), mdl.size())) return;
+    }
+}
+
+// パイプのセキュリティ記述子を作成する関数（現在のユーザー、SYSTEM、Administratorsのみ許可、失敗時はnullptr）
+// 解放はLocalFreeで行う
+static PSECURITY_DESCRIPTOR CreatePipeSecurityDescriptor()
+{
+    // 現在のユーザーのSID
+    HANDLE token = nullptr;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token)) return nullptr;
+
+    std::vector<char> buffer;
+    DWORD size = 0;
+    GetTokenInformation(token, TokenUser, nullptr, 0, &size);
+    buffer.resize(size);
+    bool ok = size > 0 && GetTokenInformation(token, TokenUser, buffer.data(), size, &size);
+    CloseHandle(token);
+    if (!ok) return nullptr;
+
+    char* sid = nullptr;
+    if (!ConvertSidToStringSidA(reinterpret_cast<TOKEN_USER*>(buffer.data())->User.Sid, &sid)) return nullptr;
+
+    // 継承しないDACL（SYSTEM、Administrators、現在のユーザーにフルアクセス）
+    std::string sddl = std::string("D:P(A;;GA;;;SY)(A;;GA;;;BA)(A;;GA;;;") + sid + ")";
+    LocalFree(sid);
+
+    PSECURITY_DESCRIPTOR descriptor = nullptr;
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptorA(sddl.c_str(), SDDL_REVISION_1, &descriptor, nullptr)) return nullptr;
+    return descriptor;
+}
+
+// ワーカースレッド（パイプのインスタンスを１つ持ち、接続を繰り返し受け付ける）
+static void Worker(const std::string& pipePath, PSECURITY_DESCRIPTOR security, uint32_t maxObjSize, const ConvertOptions& options)
+{
+    // 要求をまたいで再利用するバッファ
+    std::string objPath;
+    std::vector<char> objData;
+    std::vector<char> mdl;
+
+    SECURITY_ATTRIBUTES attributes = {};
+    attributes.nLength = sizeof(attributes);
+    attributes.lpSecurityDescriptor = security;
+    attributes.bInheritHandle = FALSE;
+
+    for (;;)
+    {
+        // ネットワーク経由の接続は拒否する
+        HANDLE pipe = CreateNamedPipeA(
+            pipePath.c_str(),
+            PIPE_ACCESS_DUPLEX,
+            PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+            PIPE_UNLIMITED_INSTANCES,
+            64 * 1024, 64 * 1024, 0, &attributes);
+
+        if (pipe == INVALID_HANDLE_VALUE)
+        {
+            std::cout << "Could not create pipe " << pipePath << std::endl;
+            return;
+        }
+
+        // クライアントの接続待ち
+        if (ConnectNamedPipe(pipe, nullptr) || GetLastError() == ERROR_PIPE_CONNECTED)
+        {
+            ServeClient(pipe, maxObjSize, options, objPath, objData, mdl);
+            FlushFileBuffers(pipe);
+            DisconnectNamedPipe(pipe);
+        }
+
+        CloseHandle(pipe);
+    }
+}
+
+// 常駐サーバーの実行関数
+int ObjToImdl::RunServer(const std::string& pipeName, unsigned int threadCount, uint32_t maxObjSize, const ConvertOptions& options)
+{
+    std::string pipePath = "\\\\.\\pipe\\" + pipeName;
+
+    if (threadCount == 0) threadCount = 1;
+
+    // すべてのパイプのインスタンスで同じセキュリティ記述子を使う
+    PSECURITY_DESCRIPTOR security = CreatePipeSecurityDescriptor();
+    if (!security)
+    {
+        std::cout << "Could not create security descriptor for " << pipePath << std::endl;
+        return 1;
+    }
+
+    std::cout << "Listening on " << pipePath << " (" << threadCount << " threads)" << std::endl;
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < threadCount; i++)
+    {
+        workers.emplace_back(Worker, pipePath, security, maxObjSize, std::cref(options));
+    }
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    LocalFree(security);
+
+    // ワーカーはエラー時のみ終了する
+    return 1;
+}
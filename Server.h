@@ -0,0 +1,22 @@
+﻿// Server.h : 名前付きパイプで変換要求を受け付ける常駐サーバー
+// DCCツールのプラグイン等からプロセスを起動せずに変換を行うために使用する
+
+#pragma once
+
+#include "Converter.h"
+#include <cstdint>
+#include <string>
+
+namespace ObjToImdl
+{
+    // 既定のパイプ名
+    constexpr const char* DefaultPipeName = "ObjToMdl";
+
+    // 既定のobjデータの最大サイズ（MiB）
+    constexpr uint32_t DefaultMaxRequestMiB = 256;
+
+    // 常駐サーバーの実行関数（エラー時のみ戻る）
+    // 同じコンピューターの同じユーザー（とSYSTEM、Administrators）からの接続のみ受け付ける
+    // maxObjSizeより大きいobjデータの要求は拒否する
+    int RunServer(const std::string& pipeName, unsigned int threadCount, uint32_t maxObjSize, const ConvertOptions& options);
+}
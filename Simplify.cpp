@@ -0,0 +1,331 @@
+﻿// Simplify.cpp : 二次誤差（QEM）によるメッシュの簡略化
+
+#include "Simplify.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+
+using namespace DirectX;
+using namespace ObjToImdl;
+
+// 二次誤差行列（対称行列なので10要素のみ保持）
+struct Quadric
+{
+    double a[10] = {};
+    double weight = 0.0;    // 加算した重みの合計
+
+    // 平面 ax + by + cz + d = 0 を重み付きで加算
+    void AddPlane(double x, double y, double z, double d, double w)
+    {
+        a[0] += w * x * x; a[1] += w * x * y; a[2] += w * x * z; a[3] += w * x * d;
+        a[4] += w * y * y; a[5] += w * y * z; a[6] += w * y * d;
+        a[7] += w * z * z; a[8] += w * z * d;
+        a[9] += w * d * d;
+        weight += w;
+    }
+
+    void Add(const Quadric& q)
+    {
+        for (int i = 0; i < 10; i++) a[i] += q.a[i];
+        weight += q.weight;
+    }
+
+    // 点 p での誤差（重みで正規化した距離の二乗）
+    double Evaluate(const XMFLOAT3& p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        double e = a[0] * x * x + 2 * a[1] * x * y + 2 * a[2] * x * z + 2 * a[3] * x
+                 + a[4] * y * y + 2 * a[5] * y * z + 2 * a[6] * y
+                 + a[7] * z * z + 2 * a[8] * z
+                 + a[9];
+        return (weight > 0.0) ? std::max(e, 0.0) / weight : 0.0;
+    }
+};
+
+// 辺の縮約候補（from を to へ縮約）
+struct Collapse
+{
+    double cost;            // 誤差
+    uint32_t from;          // 消える頂点
+    uint32_t to;            // 残る頂点
+    uint32_t fromVersion;   // 登録時の from のバージョン（古い候補の判定用）
+    uint32_t toVersion;     // 登録時の to のバージョン
+
+    bool operator>(const Collapse& other) const { return cost > other.cost; }
+};
+
+// ３点から法線（正規化なし）を求める関数
+static XMVECTOR TriangleNormal(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2)
+{
+    XMVECTOR v0 = XMLoadFloat3(&p0);
+    return XMVector3Cross(XMLoadFloat3(&p1) - v0, XMLoadFloat3(&p2) - v0);
+}
+
+// 三角形リストを段階的に簡略化する関数
+void ObjToImdl::SimplifyMesh(const std::vector<VertexPositionNormalTextureTangent>& vertices,
+                             const uint16_t* indices, size_t indexCount,
+                             const std::vector<size_t>& targets,
+                             std::vector<std::vector<uint16_t>>& levels,
+                             std::vector<float>& errors)
+{
+    levels.assign(targets.size(), {});
+    errors.assign(targets.size(), 0.0f);
+
+    // ---- メッシュ内の頂点をローカル番号に振り直す ----
+    std::unordered_map<uint16_t, uint32_t> localMap;
+    std::vector<uint16_t> globalIndex;
+    std::vector<uint32_t> tris(indexCount);
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        auto [it, inserted] = localMap.try_emplace(indices[i], static_cast<uint32_t>(globalIndex.size()));
+        if (inserted) globalIndex.push_back(indices[i]);
+        tris[i] = it->second;
+    }
+
+    const size_t vertexCount = globalIndex.size();
+    const size_t triCount = indexCount / 3;
+
+    auto position = [&](uint32_t v) -> const XMFLOAT3& { return vertices[globalIndex[v]].position; };
+
+    // ---- 動かせない頂点の判定 ----
+    std::vector<bool> locked(vertexCount, false);
+
+    // 同じ位置に別の頂点がある（UVや法線の継ぎ目）
+    {
+        std::unordered_map<uint64_t, std::vector<uint32_t>> positionMap;
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            const XMFLOAT3& p = position(v);
+            uint32_t bits[3];
+            memcpy(bits, &p, sizeof(bits));
+            uint64_t key = (static_cast<uint64_t>(bits[0]) * 73856093u) ^ (static_cast<uint64_t>(bits[1]) * 19349663u) ^ (static_cast<uint64_t>(bits[2]) * 83492791u);
+            positionMap[key].push_back(v);
+        }
+        for (const auto& [key, group] : positionMap)
+        {
+            for (size_t i = 0; i < group.size(); i++)
+            {
+                for (size_t j = i + 1; j < group.size(); j++)
+                {
+                    if (memcmp(&position(group[i]), &position(group[j]), sizeof(XMFLOAT3)) == 0)
+                    {
+                        locked[group[i]] = locked[group[j]] = true;
+                    }
+                }
+            }
+        }
+    }
+
+    // 境界の辺（１つの三角形にしか使われていない）、または非多様体の辺
+    {
+        std::unordered_map<uint64_t, uint32_t> edgeCount;
+        for (size_t t = 0; t < triCount; t++)
+        {
+            for (int e = 0; e < 3; e++)
+            {
+                uint32_t a = tris[t * 3 + e];
+                uint32_t b = tris[t * 3 + (e + 1) % 3];
+                if (a > b) std::swap(a, b);
+                edgeCount[static_cast<uint64_t>(a) << 32 | b]++;
+            }
+        }
+        for (const auto& [edge, count] : edgeCount)
+        {
+            if (count != 2)
+            {
+                locked[static_cast<uint32_t>(edge >> 32)] = true;
+                locked[static_cast<uint32_t>(edge & 0xffffffff)] = true;
+            }
+        }
+    }
+
+    // ---- 頂点ごとの二次誤差と隣接三角形 ----
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<std::vector<uint32_t>> vertexTris(vertexCount);
+    std::vector<XMFLOAT3> originalNormals(triCount);
+    for (uint32_t t = 0; t < triCount; t++)
+    {
+        const XMFLOAT3& p0 = position(tris[t * 3 + 0]);
+        const XMFLOAT3& p1 = position(tris[t * 3 + 1]);
+        const XMFLOAT3& p2 = position(tris[t * 3 + 2]);
+
+        XMFLOAT3 n;
+        XMStoreFloat3(&n, TriangleNormal(p0, p1, p2));
+        XMStoreFloat3(&originalNormals[t], XMVector3Normalize(TriangleNormal(p0, p1, p2)));
+        double length = std::sqrt(static_cast<double>(n.x) * n.x + static_cast<double>(n.y) * n.y + static_cast<double>(n.z) * n.z);
+        if (length > 0.0)
+        {
+            double nx = n.x / length, ny = n.y / length, nz = n.z / length;
+            double d = -(nx * p0.x + ny * p0.y + nz * p0.z);
+            double area = length * 0.5;
+            for (int i = 0; i < 3; i++)
+            {
+                quadrics[tris[t * 3 + i]].AddPlane(nx, ny, nz, d, area);
+            }
+        }
+
+        for (int i = 0; i < 3; i++)
+        {
+            vertexTris[tris[t * 3 + i]].push_back(t);
+        }
+    }
+
+    // ---- 縮約候補の登録 ----
+    std::vector<bool> triAlive(triCount, true);
+    std::vector<bool> vertexAlive(vertexCount, true);
+    std::vector<uint32_t> version(vertexCount, 0);
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+
+    auto pushCollapse = [&](uint32_t from, uint32_t to) {
+        if (locked[from]) return;
+        Quadric q = quadrics[from];
+        q.Add(quadrics[to]);
+        heap.push({ q.Evaluate(position(to)), from, to, version[from], version[to] });
+    };
+
+    auto pushEdges = [&](uint32_t v) {
+        for (uint32_t t : vertexTris[v])
+        {
+            if (!triAlive[t]) continue;
+            for (int i = 0; i < 3; i++)
+            {
+                uint32_t w = tris[t * 3 + i];
+                if (w == v) continue;
+                pushCollapse(v, w);
+                pushCollapse(w, v);
+            }
+        }
+    };
+
+    for (uint32_t t = 0; t < triCount; t++)
+    {
+        for (int e = 0; e < 3; e++)
+        {
+            uint32_t a = tris[t * 3 + e];
+            uint32_t b = tris[t * 3 + (e + 1) % 3];
+            pushCollapse(a, b);
+            pushCollapse(b, a);
+        }
+    }
+
+    // 隣接頂点の取得関数
+    std::vector<uint32_t> fromRing, toRing;
+    auto collectRing = [&](uint32_t v, std::vector<uint32_t>& ring) {
+        ring.clear();
+        for (uint32_t t : vertexTris[v])
+        {
+            if (!triAlive[t]) continue;
+            for (int i = 0; i < 3; i++)
+            {
+                if (tris[t * 3 + i] != v) ring.push_back(tris[t * 3 + i]);
+            }
+        }
+        std::sort(ring.begin(), ring.end());
+        ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+    };
+
+    // 縮約しても位相が変わらず、三角形が大きく傾いたり裏返ったりしないか判定する関数
+    auto canCollapse = [&](uint32_t from, uint32_t to) {
+        // 共通の隣接頂点は辺を共有する三角形の対角の頂点のみ（リンク条件）
+        size_t edgeTris = 0;
+        for (uint32_t t : vertexTris[from])
+        {
+            if (!triAlive[t]) continue;
+            if (tris[t * 3 + 0] == to || tris[t * 3 + 1] == to || tris[t * 3 + 2] == to) edgeTris++;
+        }
+        collectRing(from, fromRing);
+        collectRing(to, toRing);
+        size_t common = 0;
+        for (size_t i = 0, j = 0; i < fromRing.size() && j < toRing.size(); )
+        {
+            if (fromRing[i] < toRing[j]) i++;
+            else if (fromRing[i] > toRing[j]) j++;
+            else { common++; i++; j++; }
+        }
+        if (common != edgeTris) return false;
+
+        for (uint32_t t : vertexTris[from])
+        {
+            if (!triAlive[t]) continue;
+
+            uint32_t i0 = tris[t * 3 + 0], i1 = tris[t * 3 + 1], i2 = tris[t * 3 + 2];
+            if (i0 == to || i1 == to || i2 == to) continue;   // 縮約で消える三角形
+
+            XMVECTOR before = XMVector3Normalize(TriangleNormal(position(i0), position(i1), position(i2)));
+            if (i0 == from) i0 = to;
+            if (i1 == from) i1 = to;
+            if (i2 == from) i2 = to;
+            XMVECTOR after = XMVector3Normalize(TriangleNormal(position(i0), position(i1), position(i2)));
+
+            // 法線が縮約前または元の三角形から約75度以上変わる場合は縮約しない
+            if (XMVectorGetX(XMVector3Dot(before, after)) < 0.25f) return false;
+            if (XMVectorGetX(XMVector3Dot(XMLoadFloat3(&originalNormals[t]), after)) < 0.25f) return false;
+        }
+        return true;
+    };
+
+    // 現在の三角形リストを取得する関数
+    auto snapshot = [&](std::vector<uint16_t>& out) {
+        out.clear();
+        for (uint32_t t = 0; t < triCount; t++)
+        {
+            if (!triAlive[t]) continue;
+            for (int i = 0; i < 3; i++)
+            {
+                out.push_back(globalIndex[tris[t * 3 + i]]);
+            }
+        }
+    };
+
+    // ---- 誤差の小さい順に縮約 ----
+    size_t aliveCount = triCount;
+    double maxCost = 0.0;
+
+    for (size_t level = 0; level < targets.size(); level++)
+    {
+        while (aliveCount > targets[level] && !heap.empty())
+        {
+            Collapse c = heap.top();
+            heap.pop();
+
+            // 古い候補
+            if (!vertexAlive[c.from] || !vertexAlive[c.to]) continue;
+            if (c.fromVersion != version[c.from] || c.toVersion != version[c.to]) continue;
+
+            if (!canCollapse(c.from, c.to)) continue;
+
+            // from を to に置き換え、縮退した三角形を削除
+            for (uint32_t t : vertexTris[c.from])
+            {
+                if (!triAlive[t]) continue;
+
+                uint32_t* tri = &tris[t * 3];
+                if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)
+                {
+                    triAlive[t] = false;
+                    aliveCount--;
+                    continue;
+                }
+
+                for (int i = 0; i < 3; i++)
+                {
+                    if (tri[i] == c.from) tri[i] = c.to;
+                }
+                vertexTris[c.to].push_back(t);
+            }
+
+            vertexAlive[c.from] = false;
+            quadrics[c.to].Add(quadrics[c.from]);
+            version[c.to]++;
+            maxCost = std::max(maxCost, c.cost);
+
+            // 残った頂点の周りの候補を更新
+            pushEdges(c.to);
+        }
+
+        snapshot(levels[level]);
+        errors[level] = static_cast<float>(std::sqrt(maxCost));
+    }
+}
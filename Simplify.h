@@ -0,0 +1,20 @@
+﻿// Simplify.h : 二次誤差（QEM）によるメッシュの簡略化
+
+#pragma once
+
+#include "ObjToMdl.h"
+#include <cstdint>
+#include <vector>
+
+namespace ObjToImdl
+{
+    // 三角形リストを段階的に簡略化する関数
+    // targets（降順の三角形数）ごとに簡略化した三角形リストをlevelsに、その時点の誤差をerrorsに格納する
+    // 頂点は追加せず既存の頂点へ辺を縮約するので、元の頂点バッファをそのまま共有できる
+    // UVや法線の継ぎ目にある頂点と、メッシュの境界（マテリアルの境界を含む）にある頂点は動かさない
+    void SimplifyMesh(const std::vector<VertexPositionNormalTextureTangent>& vertices,
+                      const uint16_t* indices, size_t indexCount,
+                      const std::vector<size_t>& targets,
+                      std::vector<std::vector<uint16_t>>& levels,
+                      std::vector<float>& errors);
+}
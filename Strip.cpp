@@ -0,0 +1,92 @@
+﻿// Strip.cpp : 三角形リストをトライアングルストリップに変換する
+// 未使用の三角形から始めて、最後の辺を共有する三角形を向きが合う限り貪欲につなげる
+
+#include "Strip.h"
+#include <unordered_map>
+
+using namespace ObjToImdl;
+
+// 有向辺のキー
+static uint32_t EdgeKey(uint32_t a, uint32_t b)
+{
+    return a << 16 | b;
+}
+
+// 三角形リストをストリップに変換する関数
+void ObjToImdl::BuildStrips(const uint16_t* indices, size_t indexCount, std::vector<uint16_t>& strips)
+{
+    const size_t triangleCount = indexCount / 3;
+    strips.clear();
+
+    // 有向辺 → 三角形
+    std::unordered_map<uint32_t, uint32_t> edges;
+    edges.reserve(triangleCount * 3);
+    for (size_t i = 0; i < triangleCount; i++)
+    {
+        const uint16_t* t = &indices[i * 3];
+        for (int k = 0; k < 3; k++)
+        {
+            edges.emplace(EdgeKey(t[k], t[(k + 1) % 3]), static_cast<uint32_t>(i));
+        }
+    }
+
+    std::vector<bool> used(triangleCount, false);
+
+    // 有向辺 a→b を持つ未使用の三角形の残りの頂点を探す（ない場合はfalse）
+    auto findNext = [&](uint32_t a, uint32_t b, uint32_t& tri, uint16_t& third) {
+        auto it = edges.find(EdgeKey(a, b));
+        if (it == edges.end() || used[it->second]) return false;
+        tri = it->second;
+        const uint16_t* t = &indices[tri * 3];
+        for (int k = 0; k < 3; k++)
+        {
+            if (t[k] == a && t[(k + 1) % 3] == b)
+            {
+                third = t[(k + 2) % 3];
+                return true;
+            }
+        }
+        return false;
+    };
+
+    std::vector<uint16_t> strip;
+    for (size_t start = 0; start < triangleCount; start++)
+    {
+        if (used[start]) continue;
+        used[start] = true;
+
+        // 次の三角形につながる回転で始める（2番目の三角形は反転するので c→b の辺を持つ三角形）
+        const uint16_t* t = &indices[start * 3];
+        int rotation = 0;
+        for (int r = 0; r < 3; r++)
+        {
+            uint32_t tri;
+            uint16_t third;
+            if (findNext(t[(r + 2) % 3], t[(r + 1) % 3], tri, third))
+            {
+                rotation = r;
+                break;
+            }
+        }
+
+        strip.assign({ t[rotation], t[(rotation + 1) % 3], t[(rotation + 2) % 3] });
+
+        // k番目の三角形：偶数は (v[k], v[k+1], 新) 、奇数は (v[k+1], v[k], 新)
+        for (;;)
+        {
+            size_t k = strip.size() - 2;
+            uint16_t a = strip[k];
+            uint16_t b = strip[k + 1];
+            uint32_t tri;
+            uint16_t third;
+            bool found = (k % 2 == 0) ? findNext(a, b, tri, third) : findNext(b, a, tri, third);
+            if (!found) break;
+
+            used[tri] = true;
+            strip.push_back(third);
+        }
+
+        if (!strips.empty()) strips.push_back(StripRestartIndex);
+        strips.insert(strips.end(), strip.begin(), strip.end());
+    }
+}
@@ -0,0 +1,17 @@
+﻿// Strip.h : 三角形リストをトライアングルストリップに変換する
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ObjToImdl
+{
+    // プリミティブの再開を表すインデックス
+    constexpr uint16_t StripRestartIndex = 0xFFFF;
+
+    // 三角形リストをストリップに変換する関数（ストリップの間はStripRestartIndexで区切る）
+    // 奇数番目の三角形は表裏が反転する規則（Direct3D）に合わせて、元の三角形の向きを保つ
+    void BuildStrips(const uint16_t* indices, size_t indexCount, std::vector<uint16_t>& strips);
+}
@@ -0,0 +1,62 @@
+@echo off
+rem CompareCorpus.bat : ϊʂ𐳉f[^Ɣr
+rem
+rem ModelsATeststH_objt@ĈAOmdlt@Cif[^ĵ
+rem ̐ݒƊeIvVŕϊĔr
+rem IvVw肵ϊł́ÃIvVŒǉgZNV͔rȂi--ignore-added-sectionsj
+rem LODAXgbvȂǃCfbNXςIvVƁAgŃbV𕪂--nodes͑ΏۂɂȂ
+rem
+rem g : CompareCorpus.bat [ObjToMdl.exẽpX]iȗ x64\Release\ObjToMdl.exej
+
+setlocal
+set ROOT=%~dp0..
+set EXE=%~1
+if "%EXE%"=="" set EXE=%ROOT%\x64\Release\ObjToMdl.exe
+if not exist "%EXE%" (
+    echo Could not open %EXE%
+    exit /b 1
+)
+
+rem ƃtH_iϊʁALbVApbNt@Cj
+set WORK=%TEMP%\ObjToMdlCorpus
+if exist "%WORK%" rmdir /s /q "%WORK%"
+mkdir "%WORK%"
+
+set FAILED=0
+for %%F in ("%ROOT%\Models\*.obj" "%ROOT%\Tests\*.obj") do (
+    if exist "%%~dpnF.mdl" call :CheckModel "%%~fF" "%%~dpnF.mdl"
+)
+
+if not "%FAILED%"=="0" (
+    echo %FAILED% check^(s^) failed
+    exit /b 1
+)
+echo All checks passed
+exit /b 0
+
+rem ---- objt@CPeIvVŕϊĔr ----
+rem %1 objt@CA%2 f[^
+:CheckModel
+call :Check %1 %2 default
+call :Check %1 %2 compress --compress
+call :Check %1 %2 section-codec --section-codec xpress --section-ratio 2
+call :Check %1 %2 pack --pack "%WORK%\corpus.gpak"
+call :Check %1 %2 cache-cold --cache-dir "%WORK%\cache"
+call :Check %1 %2 cache-warm --cache-dir "%WORK%\cache"
+call :Check %1 %2 bounds --bounds
+call :Check %1 %2 meshlets --meshlets
+call :Check %1 %2 bvh --bvh
+call :Check %1 %2 object-ranges --object-ranges
+call :Check %1 %2 extended-materials --extended-materials
+exit /b 0
+
+rem ---- P̕ϊƔr ----
+rem %1 objt@CA%2 f[^A%3 OA%4ȍ~ ϊIvViȂꍇ͊gZNVSvŔrj
+:Check
+set OUT=%WORK%\%~n1_%3.mdl
+set IGNORE=--ignore-added-sections
+if "%~4"=="" set IGNORE=
+echo [%3]
+"%EXE%" %1 -o "%OUT%" -c %2 %IGNORE% %4 %5 %6 %7
+if errorlevel 1 set /a FAILED+=1
+exit /b 0
@@ -0,0 +1,159 @@
+﻿// Triangulate.cpp : 多角形の面を三角形に分割する
+// 法線の成分が最大の軸を除いた平面に投影して、三角形と凸の四角形、凸多角形はそのまま扇形に分割し、
+// 凹多角形のみ耳切り法で分割する
+
+#include "Triangulate.h"
+#include <cmath>
+
+using namespace DirectX;
+using namespace ObjToImdl;
+
+// ２次元の外積（abcが反時計回りの場合は正）
+static float Cross(const XMFLOAT2& a, const XMFLOAT2& b, const XMFLOAT2& c)
+{
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+// 点pが反時計回りの三角形abcの内側（辺上を含む）にあるか
+static bool PointInTriangle(const XMFLOAT2& p, const XMFLOAT2& a, const XMFLOAT2& b, const XMFLOAT2& c)
+{
+    return Cross(a, b, p) >= 0.0f && Cross(b, c, p) >= 0.0f && Cross(c, a, p) >= 0.0f;
+}
+
+// 多角形を三角形に分割する関数
+void ObjToImdl::TriangulatePolygon(const XMFLOAT3* points, size_t count, std::vector<uint32_t>& triangles)
+{
+    triangles.clear();
+    if (count < 3) return;
+
+    // 扇形に分割
+    auto fan = [&]() {
+        for (uint32_t i = 1; i + 1 < count; i++)
+        {
+            triangles.insert(triangles.end(), { 0, i, i + 1 });
+        }
+    };
+
+    if (count == 3)
+    {
+        fan();
+        return;
+    }
+
+    // 法線（Newellの方法）
+    XMFLOAT3 normal(0.0f, 0.0f, 0.0f);
+    for (size_t i = 0; i < count; i++)
+    {
+        const XMFLOAT3& a = points[i];
+        const XMFLOAT3& b = points[(i + 1) % count];
+        normal.x += (a.y - b.y) * (a.z + b.z);
+        normal.y += (a.z - b.z) * (a.x + b.x);
+        normal.z += (a.x - b.x) * (a.y + b.y);
+    }
+
+    // 法線の成分が最大の軸を除いて投影する（多角形が反時計回りになるように向きを合わせる）
+    float nx = std::fabs(normal.x), ny = std::fabs(normal.y), nz = std::fabs(normal.z);
+    if (nx == 0.0f && ny == 0.0f && nz == 0.0f)
+    {
+        // 面積のない多角形
+        fan();
+        return;
+    }
+    int axis = (nx >= ny && nx >= nz) ? 0 : (ny >= nz ? 1 : 2);
+    float sign = ((&normal.x)[axis] < 0.0f) ? -1.0f : 1.0f;
+
+    std::vector<XMFLOAT2> p(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const XMFLOAT3& v = points[i];
+        if (axis == 0) p[i] = XMFLOAT2(v.y * sign, v.z);
+        else if (axis == 1) p[i] = XMFLOAT2(v.z * sign, v.x);
+        else p[i] = XMFLOAT2(v.x * sign, v.y);
+    }
+
+    // 四角形は対角線0-2で分けられなければ1-3で分ける
+    if (count == 4)
+    {
+        if (Cross(p[0], p[1], p[2]) > 0.0f && Cross(p[2], p[3], p[0]) > 0.0f)
+        {
+            fan();
+        }
+        else
+        {
+            triangles.insert(triangles.end(), { 1, 2, 3, 1, 3, 0 });
+        }
+        return;
+    }
+
+    // 凸多角形は扇形に分割
+    bool convex = true;
+    for (size_t i = 0; i < count && convex; i++)
+    {
+        convex = Cross(p[(i + count - 1) % count], p[i], p[(i + 1) % count]) >= 0.0f;
+    }
+    if (convex)
+    {
+        fan();
+        return;
+    }
+
+    // ---- 耳切り法 ----
+    // 残っている頂点を双方向リストでつなぎ、凹の頂点のみ耳の内側にないかを調べる
+    std::vector<uint32_t> prev(count), next(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        prev[i] = static_cast<uint32_t>((i + count - 1) % count);
+        next[i] = static_cast<uint32_t>((i + 1) % count);
+    }
+
+    auto isReflex = [&](uint32_t i) {
+        return Cross(p[prev[i]], p[i], p[next[i]]) <= 0.0f;
+    };
+
+    std::vector<bool> reflex(count);
+    for (uint32_t i = 0; i < count; i++) reflex[i] = isReflex(i);
+
+    auto samePoint = [](const XMFLOAT2& a, const XMFLOAT2& b) {
+        return a.x == b.x && a.y == b.y;
+    };
+
+    auto isEar = [&](uint32_t i) {
+        if (reflex[i]) return false;
+        uint32_t a = prev[i], c = next[i];
+        for (uint32_t j = next[c]; j != a; j = next[j])
+        {
+            if (!reflex[j]) continue;
+            // 耳の頂点と同じ位置の頂点は内側とみなさない
+            if (samePoint(p[j], p[a]) || samePoint(p[j], p[i]) || samePoint(p[j], p[c])) continue;
+            if (PointInTriangle(p[j], p[a], p[i], p[c])) return false;
+        }
+        return true;
+    };
+
+    triangles.reserve((count - 2) * 3);
+    size_t remaining = count;
+    size_t skipped = 0;     // 耳が見つからずに進んだ数
+    uint32_t i = 0;
+    while (remaining > 3)
+    {
+        // 一周しても耳がない（自己交差などで分割できない）場合はそのまま切り取る
+        if (isEar(i) || skipped >= remaining)
+        {
+            uint32_t a = prev[i], c = next[i];
+            triangles.insert(triangles.end(), { a, i, c });
+            next[a] = c;
+            prev[c] = a;
+            remaining--;
+            reflex[a] = isReflex(a);
+            reflex[c] = isReflex(c);
+            i = c;
+            skipped = 0;
+        }
+        else
+        {
+            i = next[i];
+            skipped++;
+        }
+    }
+    triangles.insert(triangles.end(), { prev[i], i, next[i] });
+}
@@ -0,0 +1,15 @@
+﻿// Triangulate.h : 多角形の面を三角形に分割する
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ObjToImdl
+{
+    // 多角形を三角形に分割する関数（凸多角形は扇形、凹多角形は耳切り法で分割する）
+    // trianglesには多角形の頂点の番号を３つずつ、多角形と同じ向きで格納する
+    void TriangulatePolygon(const DirectX::XMFLOAT3* points, size_t count, std::vector<uint32_t>& triangles);
+}
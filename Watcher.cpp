@@ -0,0 +1,258 @@
+﻿// Watcher.cpp : ディレクトリを監視して変更されたobjファイルを再変換する監視モード
+// objファイルが変更された場合はそのファイルのみ、mtlファイルが変更された場合は
+// そのmtlファイルをmtllibで参照しているobjファイルをすべて再変換する
+
+#include "Watcher.h"
+#include <iostream>
+#include <windows.h>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <algorithm>
+#include <unordered_map>
+#include <cwctype>
+
+using namespace ObjToImdl;
+
+// 最後の変更からこの時間が経過したら再変換する（ミリ秒）
+constexpr ULONGLONG DebounceTime = 300;
+
+// 監視中のディレクトリ
+struct WatchedDirectory
+{
+    std::filesystem::path path;             // ディレクトリ名
+    HANDLE handle = INVALID_HANDLE_VALUE;   // ディレクトリのハンドル
+    OVERLAPPED overlapped = {};             // 非同期読み込み用
+    std::vector<DWORD> buffer;              // 変更通知の受け取りバッファ
+};
+
+// 監視モードの状態
+struct WatchState
+{
+    std::unordered_map<std::wstring, std::vector<std::wstring>> dependencies;  // objファイル → 参照しているmtlファイル
+    std::unordered_map<std::wstring, std::string> materialTexts;               // 読み込み済みのmtlファイル
+};
+
+// ファイルの比較用のキーを取得する関数（正規化して小文字に変換）
+static std::wstring PathKey(const std::filesystem::path& path)
+{
+    std::error_code ec;
+    std::wstring key = std::filesystem::weakly_canonical(path, ec).wstring();
+    if (ec) key = path.lexically_normal().wstring();
+
+    for (auto& c : key) c = static_cast<wchar_t>(std::towlower(c));
+    return key;
+}
+
+// 拡張子の判定関数（大文字小文字を区別しない）
+static bool HasExtension(const std::filesystem::path& path, const wchar_t* ext)
+{
+    std::wstring e = path.extension().wstring();
+    for (auto& c : e) c = static_cast<wchar_t>(std::towlower(c));
+    return e == ext;
+}
+
+// objファイルを変換する関数
+static void ConvertObj(WatchState& state, const ConvertOptions& options, const std::filesystem::path& obj)
+{
+    std::filesystem::path mdl(obj);
+    mdl.replace_extension(".mdl");
+
+    InputSource source;
+    source.path = obj.u8string();
+
+    // mtlファイルは読み込み済みの内容を再利用する
+    source.loadMaterial = [&](const std::string& fname, std::string& text) {
+        std::filesystem::path path = std::filesystem::u8path(fname);
+        auto [it, inserted] = state.materialTexts.try_emplace(PathKey(path));
+        if (inserted)
+        {
+            std::ifstream ifs(path, std::ios::binary);
+            if (!ifs)
+            {
+                state.materialTexts.erase(it);
+                return false;
+            }
+            it->second.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        }
+        text = it->second;
+        return true;
+    };
+
+    OutputSink sink;
+    sink.path = mdl.u8string();
+
+    ConvertResult result;
+    int failed = Convert(options, source, sink, &result);
+
+    // 依存関係を更新（変換に失敗してもmtlファイルの修正で再変換できるように記録する）
+    auto& deps = state.dependencies[PathKey(obj)];
+    deps.clear();
+    for (const auto& mtllib : result.materialLibraries)
+    {
+        deps.push_back(PathKey(std::filesystem::u8path(mtllib)));
+    }
+
+    std::cout << (failed ? "Failed    " : "Converted ") << obj.u8string() << std::endl;
+}
+
+// 変更されたファイルに応じて再変換する関数
+static void HandleChanges(WatchState& state, const ConvertOptions& options, const std::set<std::filesystem::path>& changes)
+{
+    std::set<std::filesystem::path> targets;
+
+    for (const auto& path : changes)
+    {
+        if (HasExtension(path, L".obj"))
+        {
+            if (std::filesystem::exists(path)) targets.insert(path);
+        }
+        else if (HasExtension(path, L".mtl"))
+        {
+            // 読み込み済みの内容を破棄して、参照しているobjファイルをすべて再変換
+            std::wstring key = PathKey(path);
+            state.materialTexts.erase(key);
+            for (const auto& [obj, deps] : state.dependencies)
+            {
+                if (std::find(deps.begin(), deps.end(), key) != deps.end())
+                {
+                    targets.insert(std::filesystem::path(obj));
+                }
+            }
+        }
+    }
+
+    for (const auto& obj : targets)
+    {
+        ConvertObj(state, options, obj);
+    }
+}
+
+// ディレクトリ内のobjファイルを取得する関数
+static void CollectObjFiles(const std::filesystem::path& dir, std::set<std::filesystem::path>& files)
+{
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(dir, ec))
+    {
+        if (entry.is_regular_file() && HasExtension(entry.path(), L".obj")) files.insert(entry.path());
+    }
+}
+
+// 変更通知の読み込みを開始する関数
+static bool BeginRead(WatchedDirectory& dir)
+{
+    ResetEvent(dir.overlapped.hEvent);
+    return ReadDirectoryChangesW(
+        dir.handle,
+        dir.buffer.data(), static_cast<DWORD>(dir.buffer.size() * sizeof(DWORD)),
+        TRUE,
+        FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE,
+        nullptr, &dir.overlapped, nullptr) != 0;
+}
+
+// 監視モードの実行関数
+int ObjToImdl::RunWatch(const std::vector<std::string>& directories, const ConvertOptions& options)
+{
+    std::vector<WatchedDirectory> watched(directories.size());
+    std::vector<HANDLE> events;
+
+    for (size_t i = 0; i < directories.size(); i++)
+    {
+        WatchedDirectory& dir = watched[i];
+        dir.path = std::filesystem::u8path(directories[i]);
+        dir.buffer.resize(16 * 1024);
+
+        dir.handle = CreateFileW(
+            dir.path.wstring().c_str(),
+            FILE_LIST_DIRECTORY,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr, OPEN_EXISTING,
+            FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+            nullptr);
+
+        if (dir.handle == INVALID_HANDLE_VALUE)
+        {
+            std::cout << "Could not open " << directories[i] << std::endl;
+            return 1;
+        }
+
+        dir.overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        events.push_back(dir.overlapped.hEvent);
+
+        if (!BeginRead(dir))
+        {
+            std::cout << "Could not watch " << directories[i] << std::endl;
+            return 1;
+        }
+    }
+
+    WatchState state;
+
+    // 起動時にすべて変換して依存関係を取得
+    std::set<std::filesystem::path> pending;
+    for (const auto& dir : watched)
+    {
+        CollectObjFiles(dir.path, pending);
+    }
+    HandleChanges(state, options, pending);
+    pending.clear();
+
+    std::cout << "Watching for changes..." << std::endl;
+
+    ULONGLONG deadline = 0;
+
+    for (;;)
+    {
+        // 変更待ちの間は無期限、変更があった場合は最後の変更から一定時間待つ
+        DWORD timeout = INFINITE;
+        if (!pending.empty())
+        {
+            ULONGLONG now = GetTickCount64();
+            timeout = (deadline > now) ? static_cast<DWORD>(deadline - now) : 0;
+        }
+
+        DWORD wait = WaitForMultipleObjects(static_cast<DWORD>(events.size()), events.data(), FALSE, timeout);
+
+        // 変更が落ち着いたので再変換
+        if (wait == WAIT_TIMEOUT)
+        {
+            HandleChanges(state, options, pending);
+            pending.clear();
+            continue;
+        }
+
+        if (wait >= WAIT_OBJECT_0 + events.size()) return 1;
+
+        WatchedDirectory& dir = watched[wait - WAIT_OBJECT_0];
+
+        DWORD bytes = 0;
+        if (!GetOverlappedResult(dir.handle, &dir.overlapped, &bytes, FALSE)) return 1;
+
+        if (bytes == 0)
+        {
+            // 通知があふれたのでディレクトリ内をすべて対象にする
+            CollectObjFiles(dir.path, pending);
+        }
+        else
+        {
+            const char* p = reinterpret_cast<const char*>(dir.buffer.data());
+            for (;;)
+            {
+                const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(p);
+
+                if (info->Action != FILE_ACTION_REMOVED && info->Action != FILE_ACTION_RENAMED_OLD_NAME)
+                {
+                    std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                    pending.insert(dir.path / name);
+                }
+
+                if (info->NextEntryOffset == 0) break;
+                p += info->NextEntryOffset;
+            }
+        }
+
+        deadline = GetTickCount64() + DebounceTime;
+
+        if (!BeginRead(dir)) return 1;
+    }
+}
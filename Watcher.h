@@ -0,0 +1,13 @@
+﻿// Watcher.h : ディレクトリを監視して変更されたobjファイルを再変換する監視モード
+
+#pragma once
+
+#include "Converter.h"
+#include <string>
+#include <vector>
+
+namespace ObjToImdl
+{
+    // 監視モードの実行関数（エラー時のみ戻る）
+    int RunWatch(const std::vector<std::string>& directories, const ConvertOptions& options);
+}